@@ -0,0 +1,49 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   gauge.c                                            :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: cmetee-b <cmetee-b@student.42.fr>          +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2025/11/26 11:08:45 by cmetee-b          #+#    #+#             */
+/*   Updated: 2025/11/26 16:22:19 by cmetee-b         ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+#include "gauge.h"
+
+void gauge_init(t_gauge *g, const uint16_t *thr, uint8_t count,
+	uint16_t band, void (*render)(uint8_t level))
+{
+	g->thr = thr;
+	g->count = count;
+	g->band = band;
+	g->level = 0;
+	g->shown = 0;
+	g->render = render;
+	g->samples = 0;
+	g->frames = 0;
+}
+
+uint8_t gauge_update(t_gauge *g, uint16_t value)
+{
+	uint8_t	level = g->level;
+
+	g->samples++;
+
+	// Montée : seuil atteint
+	while (level < g->count && value >= g->thr[level])
+		level++;
+	// Descente : il faut passer sous le seuil moins la bande
+	while (level > 0 && (uint32_t)value + g->band < g->thr[level - 1])
+		level--;
+
+	if (g->shown && level == g->level)
+		return 0;
+
+	g->level = level;
+	g->shown = 1;
+	g->render(level);
+	g->frames++;
+	return 1;
+}
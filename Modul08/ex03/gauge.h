@@ -0,0 +1,46 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   gauge.h                                            :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: cmetee-b <cmetee-b@student.42.fr>          +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2025/11/26 11:08:45 by cmetee-b          #+#    #+#             */
+/*   Updated: 2025/11/26 16:22:19 by cmetee-b         ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+#ifndef GAUGE_H
+#define GAUGE_H
+
+#include <stdint.h>
+
+/*
+** Jauge pilotée par les changements : chaque échantillon est quantifié
+** en niveau (avec hystérésis), et la trame SPI n'est envoyée que si le
+** niveau change. Un potentiomètre immobile ne génère plus aucun trafic.
+**
+** Niveau monte quand value >= thr[level]
+** Niveau descend quand value < thr[level - 1] - band
+*/
+typedef struct s_gauge
+{
+	const uint16_t	*thr;			// seuils croissants
+	uint8_t			count;			// nombre de seuils : niveaux 0..count
+	uint16_t		band;			// largeur de l'hystérésis
+	uint8_t			level;
+	uint8_t			shown;			// 0 : rien encore affiché
+	void			(*render)(uint8_t level);
+	uint32_t		samples;		// échantillons reçus
+	uint32_t		frames;			// trames envoyées
+}	t_gauge;
+
+void	gauge_init(t_gauge *g, const uint16_t *thr, uint8_t count,
+			uint16_t band, void (*render)(uint8_t level));
+
+/*
+** Nouvel échantillon : retourne 1 si une trame a été envoyée
+*/
+uint8_t	gauge_update(t_gauge *g, uint16_t value);
+
+#endif
@@ -13,41 +13,46 @@
 #include "main.h"
 
 
+static const uint16_t	g_thresholds[] = {THRESHOLD_33, THRESHOLD_66, THRESHOLD_100};
+
 int main(void)
 {
-	uint16_t adc_value;
-	uint8_t jauge_level;
+	t_gauge		gauge;
+	uint16_t	adc_value;
 	
 	adc_init();
 	spi_init();
+	uart_init();
+
+	/*
+	** Niveau de jauge (0-3), seuils 33% / 66% / 100% :
+	** 
+	** ADC 0-340:     niveau 0 (toutes éteintes) - position basse
+	** ADC 341-681:   niveau 1 (D6 seule) - 33%
+	** ADC 682-1022:  niveau 2 (D6+D7) - 66%
+	** ADC 1023:      niveau 3 (toutes) - 100%
+	**
+	** rgb_set_jauge n'est appelée que quand le niveau change
+	*/
+	gauge_init(&gauge, g_thresholds, 3, GAUGE_BAND, rgb_set_jauge);
 	
 	while (1)
 	{
 		// Lecture de la valeur du potentiomètre
 		adc_value = adc_read(POT_CHANNEL);
+		gauge_update(&gauge, adc_value);
+
+		// Trafic SPI : trames envoyées / échantillons lus
+		if (gauge.samples % REPORT_EVERY == 0)
+		{
+			uart_printstr("samples ");
+			uart_printnbr(gauge.samples);
+			uart_printstr(", frames ");
+			uart_printnbr(gauge.frames);
+			uart_printstr("\r\n");
+		}
 		
-		/*
-		** Conversion de la valeur ADC en niveau de jauge (0-3)
-		** 
-		** ADC 0-340:     niveau 0 (toutes éteintes) - position basse
-		** ADC 341-681:   niveau 1 (D6 seule) - 33%
-		** ADC 682-1023:  niveau 2 (D6+D7) - 66%
-		** ADC 1023:      niveau 3 (toutes) - 100%
-		*/
-		if (adc_value < THRESHOLD_33)
-			jauge_level = 0;
-		else if (adc_value < THRESHOLD_66)
-			jauge_level = 1;
-		else if (adc_value < 1023)
-			jauge_level = 2;
-		else
-			jauge_level = 3;
-		
-		// Affichage de la jauge
-		rgb_set_jauge(gauge_level);
-		
-		// Petit délai pour éviter le scintillement
-		_delay_ms(50);
+		_delay_ms(SAMPLE_MS);
 	}
 	
 	return 0;
@@ -4,6 +4,7 @@
 #include <avr/io.h>
 #include <util/delay.h>
 #include <avr/interrupt.h>
+#include "gauge.h"
 
 /*
 ** Canal ADC pour le potentiomètre RV1
@@ -18,6 +19,25 @@
 */
 #define THRESHOLD_33  341
 #define THRESHOLD_66  682
+#define THRESHOLD_100 1023
+
+/*
+** Hystérésis : pour redescendre d'un niveau il faut passer 8 LSB sous
+** le seuil (le bruit de l'ADC ne fait plus clignoter la jauge)
+*/
+#define GAUGE_BAND    8
+
+/* Période d'échantillonnage (ms) et rapport UART (tous les N échantillons) */
+#define SAMPLE_MS     10
+#define REPORT_EVERY  100
+
+# define UART_BAUDRATE 115200
+
+/* UART (rapport trames / échantillons) */
+void uart_init(void);
+void uart_tx(char c);
+void uart_printstr(const char *str);
+void uart_printnbr(uint32_t n);
 
 
 /* SPI & APA102 & RGB */
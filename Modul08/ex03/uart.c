@@ -0,0 +1,55 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   uart.c                                             :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: cmetee-b <cmetee-b@student.42.fr>          +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2025/11/26 11:08:45 by cmetee-b          #+#    #+#             */
+/*   Updated: 2025/11/26 16:22:19 by cmetee-b         ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+#include "main.h"
+
+void uart_init(void)
+{
+	unsigned int ubrr = (F_CPU / (8UL * UART_BAUDRATE)) - 1;
+
+	UCSR0A = (1 << U2X0);
+
+	UBRR0H = (unsigned int)(ubrr >> 8);
+	UBRR0L = (unsigned char)ubrr;
+
+	UCSR0B = (1 << TXEN0);
+
+	UCSR0C = (1 << UCSZ01) | (1 << UCSZ00);
+}
+
+void uart_tx(char c)
+{
+	while (!(UCSR0A & (1 << UDRE0)))
+		;
+	
+	UDR0 = c;
+}
+
+void uart_printstr(const char *str)
+{
+	while (*str)
+		uart_tx(*str++);
+}
+
+void uart_printnbr(uint32_t n)
+{
+	char	buf[10];
+	uint8_t	i = 0;
+
+	do
+	{
+		buf[i++] = '0' + n % 10;
+		n /= 10;
+	} while (n);
+	while (i)
+		uart_tx(buf[--i]);
+}
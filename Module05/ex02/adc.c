@@ -11,6 +11,8 @@
 /* ************************************************************************** */
 
 #include "uart.h"
+#include "scope.h"
+#include <avr/sleep.h>
 
 void adc_init(void)
 {
@@ -64,3 +66,54 @@ uint16_t adc_read(uint8_t channel)
     // Lecture 10 bits : ADCL puis ADCH (ordre obligatoire, page 259)
     return ADC;
 }
+
+#if !SCOPE
+
+uint16_t adc_read_quiet(uint8_t channel)
+{
+    uint8_t sreg = SREG;
+
+    /* Horloges I/O coupées pendant le sommeil : un octet encore en cours
+     * d'émission serait corrompu
+     */
+    uart_flush();
+
+    ADMUX = (ADMUX & 0b11110000) | (channel & 0b00001111);
+
+    /* ADIF effacé (écrire 1) pour ne pas être réveillé par une ancienne
+     * conversion, puis ADIE : c'est l'interruption de fin de conversion
+     * qui réveille le CPU. Le vecteur ADC est celui du scanner
+     * (adc_scan.c), qui ne fait rien quand le scan est arrêté.
+     */
+    ADCSRA |= (1 << ADIF) | (1 << ADIE);
+
+    /* SLEEP_MODE_ADC (10.5 ADC Noise Reduction Mode) : CPU et horloge
+     * I/O arrêtés, la conversion démarre toute seule à l'entrée en
+     * sommeil (ADSC non mis à 1 ici)
+     * sei() puis sleep_cpu() : l'instruction qui suit sei() s'exécute
+     * toujours avant une interruption, pas de réveil perdu
+     */
+    set_sleep_mode(SLEEP_MODE_ADC);
+    cli();
+    sleep_enable();
+    sei();
+    sleep_cpu();
+
+    /* Réveil par une autre source (INT0, TWI...) : on se rendort tant
+     * que la conversion n'est pas finie
+     */
+    cli();
+    while (ADCSRA & (1 << ADSC))
+    {
+        sei();
+        sleep_cpu();
+        cli();
+    }
+    sleep_disable();
+    ADCSRA &= ~(1 << ADIE);
+    SREG = sreg;
+
+    return ADC;
+}
+
+#endif
@@ -0,0 +1,246 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   adc_scan.c                                         :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: cmetee-b <cmetee-b@student.42.fr>          +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2025/11/21 10:31:08 by cmetee-b          #+#    #+#             */
+/*   Updated: 2025/11/21 17:10:03 by cmetee-b         ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+#include "uart.h"
+#include "scope.h"
+#include "adc_scan.h"
+
+#if !SCOPE
+
+static t_scan_slot      slots[ADC_SCAN_MAX];
+static uint8_t          nb_slots = 0;
+static volatile uint8_t current = 0;        // slot en cours de conversion
+static uint16_t         lfsr = 0xACE1;      // pseudo-aléatoire pour le dither
+
+/* Mesure de Vcc intercalée entre deux tours de scan */
+#define VBG_MUX     0x0E                    // 1.1V (VBG), Table 24-4
+static uint16_t          vcc_countdown = ADC_VCC_PERIOD;
+static uint8_t           vcc_phase = 0;     // conversions VBG restantes
+static uint16_t          vbg_acc = 0;
+static volatile uint16_t vbg_sum = 0;       // dernière somme complète
+static volatile uint8_t  vbg_seq = 0;       // incrémenté à chaque mesure
+static uint8_t           vcc_seq = 0;       // vbg_seq du cache vcc_mv
+static uint16_t          vcc_mv = ADC_VCC_DEFAULT_MV;
+
+/* Sélectionne le canal du slot (MUX3:0, Table 24-4) en gardant REFS/ADLAR */
+static void adc_scan_select(uint8_t slot)
+{
+    ADMUX = (ADMUX & 0xF0) | (slots[slot].channel & 0x0F);
+}
+
+void adc_scan_init(const uint8_t *channels, uint8_t count)
+{
+    adc_scan_stop();
+
+    if (count > ADC_SCAN_MAX)
+        count = ADC_SCAN_MAX;
+    for (uint8_t i = 0; i < count; i++)
+    {
+        slots[i].channel = channels[i];
+        slots[i].active = 0;
+        slots[i].value[0] = 0;
+        slots[i].count[0] = 0;
+        slots[i].os_bits = 0;
+        slots[i].dither = 0;
+        slots[i].os_count = 0;
+        slots[i].acc = 0;
+    }
+    nb_slots = count;
+    if (count == 0)
+        return;
+
+    current = 0;
+    /* Première mesure de Vcc dès la fin du premier tour */
+    vcc_phase = 0;
+    vcc_countdown = 1;
+    adc_scan_select(0);
+
+    /* Pas d'auto-trigger (ADATE = 0) : c'est l'ISR qui relance chaque
+     * conversion, après avoir changé de canal. En free running, la
+     * conversion suivante serait déjà partie sur l'ancien canal.
+     * ADIE : interruption de fin de conversion (vecteur 21)
+     */
+    ADCSRA &= ~(1 << ADATE);
+    ADCSRA |= (1 << ADIE) | (1 << ADIF) | (1 << ADSC);
+}
+
+void adc_scan_stop(void)
+{
+    ADCSRA &= ~(1 << ADIE);
+    /* Laisser finir une éventuelle conversion en cours */
+    while (ADCSRA & (1 << ADSC))
+        ;
+    nb_slots = 0;
+}
+
+/* Vecteur 21 - ADC Conversion Complete
+ * ~3µs par conversion au lieu de ~104µs d'attente active dans adc_read
+ */
+ISR(ADC_vect)
+{
+    t_scan_slot *slot = &slots[current];
+    uint8_t      w = slot->active ^ 1;
+
+    if (nb_slots == 0)
+        return;
+
+    if (vcc_phase)
+    {
+        /* Les ADC_VCC_SETTLE premières conversions sont jetées */
+        if (vcc_phase <= ADC_VCC_SAMPLES)
+            vbg_acc += ADC;
+        if (--vcc_phase)
+        {
+            ADCSRA |= (1 << ADSC);
+            return;
+        }
+        vbg_sum = vbg_acc;
+        vbg_seq++;
+        /* Reprise du scan là où il s'était arrêté */
+        adc_scan_select(current);
+        ADCSRA |= (1 << ADSC);
+        return;
+    }
+
+    slot->acc += ADC;
+    if (++slot->os_count >= (uint8_t)(1 << (2 * slot->os_bits)))
+    {
+        uint16_t result = slot->acc;
+
+        if (slot->dither)
+        {
+            /* LFSR 16 bits (Galois, polynôme 0xB400) */
+            lfsr = (lfsr >> 1) ^ (-(lfsr & 1) & 0xB400);
+            result += lfsr & ((1 << slot->os_bits) - 1);
+        }
+        /* Écriture dans la copie inactive, puis bascule (écriture d'un
+         * octet = atomique) : le main ne voit jamais une valeur à moitié
+         * écrite
+         */
+        slot->value[w] = result >> slot->os_bits;
+        slot->count[w] = slot->count[slot->active] + 1;
+        slot->active = w;
+        slot->acc = 0;
+        slot->os_count = 0;
+    }
+
+    /* ADMUX peut être changé dès la fin de conversion (24.5 Changing
+     * Channel or Reference Selection), puis on relance
+     */
+    if (++current >= nb_slots)
+    {
+        current = 0;
+        if (--vcc_countdown == 0)
+        {
+            vcc_countdown = ADC_VCC_PERIOD;
+            vcc_phase = ADC_VCC_SETTLE + ADC_VCC_SAMPLES;
+            vbg_acc = 0;
+            ADMUX = (ADMUX & 0xF0) | VBG_MUX;
+            ADCSRA |= (1 << ADSC);
+            return;
+        }
+    }
+    adc_scan_select(current);
+    ADCSRA |= (1 << ADSC);
+}
+
+static t_scan_slot *adc_scan_find(uint8_t channel)
+{
+    for (uint8_t i = 0; i < nb_slots; i++)
+        if (slots[i].channel == channel)
+            return &slots[i];
+    return 0;
+}
+
+void adc_scan_set_oversampling(uint8_t channel, uint8_t extra_bits,
+                               uint8_t dither)
+{
+    t_scan_slot *slot = adc_scan_find(channel);
+    uint8_t      sreg = SREG;
+
+    if (!slot)
+        return;
+    if (extra_bits > ADC_OS_MAX_BITS)
+        extra_bits = ADC_OS_MAX_BITS;
+    /* Changement de résolution : la somme en cours est jetée */
+    cli();
+    slot->os_bits = extra_bits;
+    slot->dither = dither;
+    slot->os_count = 0;
+    slot->acc = 0;
+    SREG = sreg;
+}
+
+uint8_t adc_scan_bits(uint8_t channel)
+{
+    t_scan_slot *slot = adc_scan_find(channel);
+
+    return slot ? 10 + slot->os_bits : 10;
+}
+
+uint8_t adc_scan_read(uint8_t channel, uint16_t *value, uint16_t *count)
+{
+    t_scan_slot *slot = adc_scan_find(channel);
+    uint8_t      a;
+
+    if (!slot)
+        return 0;
+    /* Si l'ISR a basculé pendant la lecture, on relit */
+    do
+    {
+        a = slot->active;
+        *value = slot->value[a];
+        *count = slot->count[a];
+    } while (a != slot->active);
+    return 1;
+}
+
+uint16_t adc_vcc_mv(void)
+{
+    uint8_t  sreg;
+    uint16_t sum;
+    uint8_t  seq;
+
+    /* Division 32 bits seulement quand une nouvelle mesure est arrivée */
+    if (vbg_seq == vcc_seq)
+        return vcc_mv;
+    sreg = SREG;
+    cli();
+    sum = vbg_sum;
+    seq = vbg_seq;
+    SREG = sreg;
+    if (sum)
+        vcc_mv = ((uint32_t)ADC_VBG_MV * 1024 * ADC_VCC_SAMPLES + sum / 2) / sum;
+    vcc_seq = seq;
+    return vcc_mv;
+}
+
+uint16_t adc_read_mv(uint8_t channel)
+{
+    uint16_t value = 0;
+    uint16_t count;
+
+    if (!adc_scan_read(channel, &value, &count))
+        return 0;
+    return ((uint32_t)value * adc_vcc_mv()) >> adc_scan_bits(channel);
+}
+
+uint16_t adc_scan_get(uint8_t channel)
+{
+    uint16_t value = 0;
+    uint16_t count;
+
+    adc_scan_read(channel, &value, &count);
+    return value;
+}
+
+#endif
@@ -0,0 +1,109 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   adc_scan.h                                         :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: cmetee-b <cmetee-b@student.42.fr>          +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2025/11/21 10:31:08 by cmetee-b          #+#    #+#             */
+/*   Updated: 2025/11/21 17:12:45 by cmetee-b         ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+#ifndef ADC_SCAN_H
+#define ADC_SCAN_H
+
+#include <stdint.h>
+
+/* Scanner ADC : l'ISR "conversion terminée" range le résultat puis
+ * passe ADMUX au canal suivant de la liste et relance une conversion.
+ * Le main lit la dernière valeur de n'importe quel canal en quelques
+ * cycles, sans attendre de conversion.
+ *
+ * Utilise l'ISR ADC : pas compilé en mode oscilloscope (SCOPE=1), et
+ * adc_read() ne doit pas être appelé pendant que le scanner tourne.
+ */
+#define ADC_SCAN_MAX    8
+
+/* Suréchantillonnage + décimation (AVR121) : 4^n conversions sommées puis
+ * décalées de n bits donnent n bits de plus. Le bruit naturel de l'entrée
+ * doit dépasser 1 LSB pour que ça marche (c'est le cas sur RV1/LDR/NTC).
+ *   n = 0 : 10 bits, 1 conversion par résultat
+ *   n = 1 : 11 bits, 4 conversions
+ *   n = 2 : 12 bits, 16 conversions
+ *   n = 3 : 13 bits, 64 conversions (somme max 64 * 1023 < 2^16)
+ */
+#define ADC_OS_MAX_BITS 3
+
+/* Mesure de Vcc en tâche de fond : tous les ADC_VCC_PERIOD tours de scan,
+ * l'ISR passe sur la référence interne 1.1V (MUX = 1110, mesurée contre
+ * AVCC), jette ADC_VCC_SETTLE conversions le temps qu'elle se stabilise
+ * puis en somme ADC_VCC_SAMPLES.  Vcc = VBG × 1024 / ADC.
+ * Par défaut : 12 conversions tous les 256 tours (~1.5% du temps ADC à
+ * 3 canaux), Vcc rafraîchi toutes les ~80ms. Les lectures normales ne
+ * paient jamais l'attente de stabilisation.
+ * ADC_VBG_MV : la bandgap vaut 1.0-1.2V selon la puce (Table 28-11),
+ * à mesurer une fois au voltmètre pour une précision meilleure que 10%.
+ */
+# ifndef ADC_VCC_PERIOD
+#  define ADC_VCC_PERIOD    256
+# endif
+# ifndef ADC_VCC_SETTLE
+#  define ADC_VCC_SETTLE    8
+# endif
+# ifndef ADC_VCC_SAMPLES
+#  define ADC_VCC_SAMPLES   4
+# endif
+# ifndef ADC_VBG_MV
+#  define ADC_VBG_MV        1100
+# endif
+# define ADC_VCC_DEFAULT_MV 5000     // avant la première mesure
+
+typedef struct s_scan_slot
+{
+    uint8_t           channel;
+    volatile uint8_t  active;       // copie complète, lisible par le main
+    volatile uint16_t value[2];     // double buffer : l'ISR écrit l'autre
+    volatile uint16_t count[2];     // nombre de résultats (modulo 2^16)
+    uint8_t           os_bits;      // n : bits gagnés par suréchantillonnage
+    uint8_t           dither;       // arrondi aléatoire à la décimation
+    uint8_t           os_count;     // conversions déjà sommées
+    uint16_t          acc;          // somme en cours
+} t_scan_slot;
+
+/* Démarre le scan des count canaux de la liste (ADC0-ADC8)
+ * adc_init() doit avoir été appelé avant
+ */
+void     adc_scan_init(const uint8_t *channels, uint8_t count);
+
+void     adc_scan_stop(void);
+
+/* Résolution d'un canal déjà dans la liste : 10 + extra_bits bits
+ * dither = 1 : le reste de la décimation est arrondi aléatoirement au
+ * lieu d'être tronqué (pas de biais vers le bas, pas de marches fixes)
+ */
+void     adc_scan_set_oversampling(uint8_t channel, uint8_t extra_bits,
+                                   uint8_t dither);
+
+/* Résolution des valeurs du canal : 10 + extra_bits */
+uint8_t  adc_scan_bits(uint8_t channel);
+
+/* Dernière valeur du canal, sur 10 à 13 bits (0 s'il n'est pas scanné) */
+uint16_t adc_scan_get(uint8_t channel);
+
+/* Dernière tension d'alimentation mesurée (mV), 5000 avant la première */
+uint16_t adc_vcc_mv(void);
+
+/* Dernière valeur du canal en mV, corrigée par Vcc mesuré :
+ * mV = valeur × Vcc / 2^bits, en entier
+ * Utile pour une tension absolue (RV1 en diviseur de tension) ; la NTC
+ * et la LDR sont des ponts alimentés par AVCC, donc déjà ratiométriques
+ */
+uint16_t adc_read_mv(uint8_t channel);
+
+/* Valeur + numéro d'échantillon, lus ensemble (même conversion)
+ * Retourne 0 si le canal n'est pas dans la liste
+ */
+uint8_t  adc_scan_read(uint8_t channel, uint16_t *value, uint16_t *count);
+
+#endif
@@ -0,0 +1,98 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   adc_sched.c                                        :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: cmetee-b <cmetee-b@student.42.fr>          +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2025/11/25 10:20:51 by cmetee-b          #+#    #+#             */
+/*   Updated: 2025/11/25 17:03:14 by cmetee-b         ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+#include "uart.h"
+#include "adc_sched.h"
+
+#define NO_TASK     -1
+
+static t_adc_task tasks[ADC_SCHED_MAX];
+static uint8_t    nb_tasks = 0;
+static int8_t     running = NO_TASK;    // tâche dont la conversion est en cours
+static uint32_t   conversions = 0;
+
+int8_t adc_sched_add(uint8_t channel, uint16_t period_ms, t_adc_cb callback)
+{
+    t_adc_task *task;
+
+    if (nb_tasks >= ADC_SCHED_MAX || period_ms == 0)
+        return NO_TASK;
+    task = &tasks[nb_tasks];
+    task->channel = channel;
+    task->period_ms = period_ms;
+    task->due_ms = (uint16_t)timer_millis() + nb_tasks;
+    task->callback = callback;
+    task->value = 0;
+    task->count = 0;
+    return nb_tasks++;
+}
+
+void adc_sched_poll(void)
+{
+    uint16_t now;
+    int16_t  late;
+    int16_t  worst = -1;
+    int8_t   next = NO_TASK;
+
+    /* Conversion en cours : rien à faire tant que ADSC est à 1 */
+    if (running != NO_TASK)
+    {
+        t_adc_task *task = &tasks[running];
+
+        if (ADCSRA & (1 << ADSC))
+            return;
+        task->value = ADC;
+        task->count++;
+        conversions++;
+        running = NO_TASK;
+        if (task->callback)
+            task->callback(task->channel, task->value);
+    }
+
+    /* Tâche la plus en retard parmi celles arrivées à échéance */
+    now = (uint16_t)timer_millis();
+    for (uint8_t i = 0; i < nb_tasks; i++)
+    {
+        late = (int16_t)(now - tasks[i].due_ms);
+        if (late > worst)
+        {
+            worst = late;
+            next = i;
+        }
+    }
+    if (next == NO_TASK)
+        return;
+
+    /* Prochaine échéance calée sur la période, sauf si on a pris plus
+     * d'une période de retard (main bloqué) : on repart de maintenant
+     */
+    if (worst >= (int16_t)tasks[next].period_ms)
+        tasks[next].due_ms = now + tasks[next].period_ms;
+    else
+        tasks[next].due_ms += tasks[next].period_ms;
+
+    ADMUX = (ADMUX & 0xF0) | (tasks[next].channel & 0x0F);
+    ADCSRA |= (1 << ADSC);
+    running = next;
+}
+
+uint16_t adc_sched_get(int8_t task)
+{
+    if (task < 0 || task >= nb_tasks)
+        return 0;
+    return tasks[task].value;
+}
+
+uint32_t adc_sched_conversions(void)
+{
+    return conversions;
+}
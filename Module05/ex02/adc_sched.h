@@ -0,0 +1,64 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   adc_sched.h                                        :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: cmetee-b <cmetee-b@student.42.fr>          +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2025/11/25 10:20:51 by cmetee-b          #+#    #+#             */
+/*   Updated: 2025/11/25 17:03:14 by cmetee-b         ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+#ifndef ADC_SCHED_H
+#define ADC_SCHED_H
+
+#include <stdint.h>
+
+/* Ordonnanceur ADC : chaque canal a sa propre période (ms). Une seule
+ * conversion à la fois, lancée puis récupérée par adc_sched_poll() sans
+ * attente active : le CPU ne tourne pas pendant les ~104µs de conversion,
+ * et l'ADC ne travaille que pour les conversions demandées
+ * (pot 100Hz + LDR 10Hz + NTC 1Hz = 111 conversions/s, ~1.2% de l'ADC).
+ *
+ * Base de temps : timer_millis() (timer_init() avant)
+ * N'utilise pas l'interruption ADC : à ne pas mélanger avec le scanner
+ * (adc_scan) ni le mode oscilloscope.
+ */
+#ifndef ADC_SCHED_MAX
+# define ADC_SCHED_MAX  4
+#endif
+
+/* Appelée depuis adc_sched_poll (contexte du main, pas d'ISR) */
+typedef void (*t_adc_cb)(uint8_t channel, uint16_t value);
+
+typedef struct s_adc_task
+{
+    uint8_t  channel;
+    uint16_t period_ms;
+    uint16_t due_ms;        // prochaine échéance (16 bits, comparaison signée)
+    t_adc_cb callback;      // 0 : résultat seulement rangé dans value
+    uint16_t value;         // dernière conversion
+    uint16_t count;         // nombre de conversions (modulo 2^16)
+} t_adc_task;
+
+/* Ajoute un canal (période 1 à 32767 ms), retourne son numéro de tâche
+ * ou -1 si la table est pleine. Les premières échéances sont décalées d'une ms par tâche :
+ * des périodes multiples l'une de l'autre ne tombent jamais sur la
+ * même milliseconde.
+ */
+int8_t   adc_sched_add(uint8_t channel, uint16_t period_ms, t_adc_cb callback);
+
+/* À appeler le plus souvent possible dans la boucle principale :
+ * récupère la conversion terminée (callback) et lance la plus en retard
+ * des tâches arrivées à échéance
+ */
+void     adc_sched_poll(void);
+
+/* Dernière valeur de la tâche */
+uint16_t adc_sched_get(int8_t task);
+
+/* Conversions faites depuis le démarrage (taux d'occupation de l'ADC) */
+uint32_t adc_sched_conversions(void);
+
+#endif
@@ -0,0 +1,149 @@
+#!/usr/bin/env python3
+"""Génère ntc_table.h : table PROGMEM température(ADC) de la NTC sur ADC2.
+
+Montage (défaut) : R série entre AVCC et ADC2, NTC entre ADC2 et GND
+    ADC / 2^bits = R_ntc / (R_ntc + R_serie)
+Modèle beta :
+    1/T = 1/T25 + ln(R_ntc / R25) / beta        (T en kelvin)
+
+La table a 2^TABLE_BITS + 1 points régulièrement espacés sur toute la
+plage ADC, en centièmes de °C. Le firmware (ntc.c) interpole entre deux
+points en entier. Après génération, le script rejoue cette interpolation
+entière sur tous les codes ADC 10 et 12 bits et la compare à la formule
+exacte : il échoue (code 1) si l'écart dépasse --max-error.
+
+    python3 gen_ntc_table.py --r25 10000 --beta 3950 --rseries 10000 -o ../ntc_table.h
+"""
+
+import argparse
+import math
+import sys
+
+T0 = 273.15
+
+
+def exact_celsius(ratio, args):
+    """Température exacte pour ratio = Vadc / Vref (0 < ratio < 1)."""
+    if args.ntc_high:
+        r_ntc = args.rseries * (1.0 - ratio) / ratio
+    else:
+        r_ntc = args.rseries * ratio / (1.0 - ratio)
+    inv_t = 1.0 / (25.0 + T0) + math.log(r_ntc / args.r25) / args.beta
+    return 1.0 / inv_t - T0
+
+
+def table_centi(ratio, args):
+    """Valeur stockée : centièmes de °C, bornée à int16 (±320°C).
+
+    Les points au-delà de [t_min, t_max] ne sont pas ramenés aux bornes :
+    le segment qui chevauche une borne garderait sinon une pente fausse.
+    C'est le résultat interpolé qui est borné (ntc.c).
+    """
+    lo, hi = -32000, 32000
+    if ratio <= 0.0:
+        return hi if not args.ntc_high else lo
+    if ratio >= 1.0:
+        return lo if not args.ntc_high else hi
+    t = round(exact_celsius(ratio, args) * 100)
+    return max(lo, min(hi, t))
+
+
+def build_table(args):
+    n = 1 << args.table_bits
+    return [table_centi(i / n, args) for i in range(n + 1)]
+
+
+def interpolate(table, code, bits, table_bits, t_min, t_max):
+    """Même calcul que ntc_centi_celsius() dans ntc.c."""
+    x = code << (16 - bits)
+    frac_bits = 16 - table_bits
+    idx = x >> frac_bits
+    frac = x & ((1 << frac_bits) - 1)
+    a, b = table[idx], table[idx + 1]
+    # Décalage arithmétique de l'int32_t (arrondi vers -inf, comme avr-gcc)
+    t = a + (((b - a) * frac) >> frac_bits)
+    return max(t_min * 100, min(t_max * 100, t))
+
+
+def check(table, args):
+    """Écart max (°C) entre table interpolée et formule, dans [t_min, t_max]."""
+    worst = 0.0
+    worst_at = None
+    for bits in (10, 12):
+        for code in range(1, 1 << bits):
+            exact = exact_celsius(code / (1 << bits), args)
+            if exact < args.t_min or exact > args.t_max:
+                continue
+            t = interpolate(table, code, bits, args.table_bits,
+                            args.t_min, args.t_max)
+            err = abs(t / 100.0 - exact)
+            if err > worst:
+                worst, worst_at = err, (bits, code, exact)
+    return worst, worst_at
+
+
+def write_header(table, args, out):
+    out.write("/* Généré par host/gen_ntc_table.py - ne pas modifier */\n")
+    out.write("/* R25 = %g ohm, beta = %g K, R série = %g ohm, NTC côté %s */\n"
+              % (args.r25, args.beta, args.rseries,
+                 "AVCC" if args.ntc_high else "GND"))
+    out.write("\n#ifndef NTC_TABLE_H\n#define NTC_TABLE_H\n\n")
+    out.write("#include <avr/pgmspace.h>\n\n")
+    out.write("/* Paramètres du montage, pour host/test_ntc.c */\n")
+    out.write("#define NTC_R25         %.17g\n" % args.r25)
+    out.write("#define NTC_BETA        %.17g\n" % args.beta)
+    out.write("#define NTC_RSERIES     %.17g\n" % args.rseries)
+    out.write("#define NTC_HIGH        %d\n\n" % (1 if args.ntc_high else 0))
+    out.write("#define NTC_TABLE_BITS  %d\n" % args.table_bits)
+    out.write("#define NTC_T_MIN       %d    // °C, bornes de la table\n" % args.t_min)
+    out.write("#define NTC_T_MAX       %d\n\n" % args.t_max)
+    out.write("/* Centièmes de °C pour ADC = i * 2^16 / %d (fraction 16 bits) */\n"
+              % (1 << args.table_bits))
+    out.write("static const int16_t ntc_table[%d] PROGMEM =\n{\n" % len(table))
+    for i in range(0, len(table), 8):
+        row = ", ".join("%6d" % v for v in table[i:i + 8])
+        out.write("    %s,\n" % row)
+    out.write("};\n\n#endif\n")
+
+
+def main():
+    p = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    p.add_argument("--r25", type=float, default=10000.0, help="R NTC à 25°C (ohm)")
+    p.add_argument("--beta", type=float, default=3950.0, help="coefficient beta (K)")
+    p.add_argument("--rseries", type=float, default=10000.0, help="R série (ohm)")
+    p.add_argument("--ntc-high", action="store_true",
+                   help="NTC entre AVCC et ADC2 (R série vers GND)")
+    p.add_argument("--table-bits", type=int, default=7,
+                   help="2^N + 1 points (défaut 7 : 129 points, 258 octets)")
+    p.add_argument("--t-min", type=int, default=-40)
+    p.add_argument("--t-max", type=int, default=125)
+    p.add_argument("--max-error", type=float, default=0.5,
+                   help="écart max toléré (°C) entre t-min et t-max")
+    p.add_argument("-o", "--output", default="-")
+    args = p.parse_args()
+
+    # (b - a) * frac doit tenir sur un int32_t : frac < 2^(16 - N)
+    if not 4 <= args.table_bits <= 10:
+        p.error("--table-bits doit être entre 4 et 10")
+
+    table = build_table(args)
+    worst, at = check(table, args)
+    msg = "ntc: %d points, écart max %.3f°C" % (len(table), worst)
+    if at:
+        msg += " (code %d sur %d bits, %.2f°C)" % (at[1], at[0], at[2])
+    print(msg, file=sys.stderr)
+    if worst > args.max_error:
+        print("ntc: écart > %.2f°C, augmenter --table-bits" % args.max_error,
+              file=sys.stderr)
+        return 1
+
+    if args.output == "-":
+        write_header(table, args, sys.stdout)
+    else:
+        with open(args.output, "w") as out:
+            write_header(table, args, out)
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
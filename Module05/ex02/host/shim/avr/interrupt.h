@@ -0,0 +1,4 @@
+#ifndef SHIM_AVR_INTERRUPT_H
+#define SHIM_AVR_INTERRUPT_H
+
+#endif
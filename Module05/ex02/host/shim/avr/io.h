@@ -0,0 +1,7 @@
+/* Compilation sur PC de ntc.c : uart.h n'a besoin que des types */
+#ifndef SHIM_AVR_IO_H
+#define SHIM_AVR_IO_H
+
+#include <stdint.h>
+
+#endif
@@ -0,0 +1,10 @@
+/* Flash et RAM confondues sur PC : la table PROGMEM se lit directement */
+#ifndef SHIM_AVR_PGMSPACE_H
+#define SHIM_AVR_PGMSPACE_H
+
+#include <stdint.h>
+
+#define PROGMEM
+#define pgm_read_word(addr) (*(const uint16_t *)(addr))
+
+#endif
@@ -0,0 +1,4 @@
+#ifndef SHIM_UTIL_DELAY_H
+#define SHIM_UTIL_DELAY_H
+
+#endif
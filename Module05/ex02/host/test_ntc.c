@@ -0,0 +1,79 @@
+/* Test PC de ntc.c : la table générée (ntc_table.h) et l'interpolation
+ * entière du firmware, comparées au modèle beta en double sur tous les
+ * codes 10, 12 et 13 bits dont la température est dans
+ * [NTC_T_MIN, NTC_T_MAX]. Échoue au-delà de MAX_ERR.
+ *
+ *     make test           (ntc_table.h régénéré avec les NTC_* du Makefile)
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include "../ntc.h"
+#include "../ntc_table.h"
+
+#define T0          273.15
+#define MAX_ERR     0.5         // °C, même seuil que gen_ntc_table.py
+
+/* ntc.c lit le scanner dans ntc_read_centi_celsius : pas utilisé ici */
+uint16_t adc_scan_get(uint8_t channel)
+{
+    (void)channel;
+    return 0;
+}
+
+uint8_t adc_scan_bits(uint8_t channel)
+{
+    (void)channel;
+    return 10;
+}
+
+/* 1/T = 1/T25 + ln(R / R25) / beta, R tirée du pont diviseur */
+static double exact_celsius(double ratio)
+{
+    double r_ntc;
+
+    if (NTC_HIGH)
+        r_ntc = NTC_RSERIES * (1.0 - ratio) / ratio;
+    else
+        r_ntc = NTC_RSERIES * ratio / (1.0 - ratio);
+    return 1.0 / (1.0 / (25.0 + T0) + log(r_ntc / NTC_R25) / NTC_BETA) - T0;
+}
+
+int main(void)
+{
+    static const uint8_t bits_list[3] = {10, 12, 13};
+    double               worst = 0;
+    uint16_t             worst_code = 0;
+    uint8_t              worst_bits = 0;
+    uint32_t             checked = 0;
+
+    for (uint8_t b = 0; b < 3; b++)
+    {
+        uint8_t bits = bits_list[b];
+
+        for (uint32_t code = 1; code < (1UL << bits); code++)
+        {
+            double exact = exact_celsius(code / (double)(1UL << bits));
+            double err;
+
+            if (exact < NTC_T_MIN || exact > NTC_T_MAX)
+                continue;
+            err = fabs(ntc_centi_celsius(code, bits) / 100.0 - exact);
+            checked++;
+            if (err > worst)
+            {
+                worst = err;
+                worst_code = code;
+                worst_bits = bits;
+            }
+        }
+    }
+    printf("ntc : %lu codes, ecart max %.3f C (code %u sur %u bits)\n",
+           (unsigned long)checked, worst, worst_code, worst_bits);
+    if (!checked || worst > MAX_ERR)
+    {
+        printf("ntc : ECHEC (> %.2f C)\n", MAX_ERR);
+        return 1;
+    }
+    return 0;
+}
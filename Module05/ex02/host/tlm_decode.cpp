@@ -0,0 +1,533 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   tlm_decode.cpp                                     :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: cmetee-b <cmetee-b@student.42.fr>          +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2025/11/19 09:41:22 by cmetee-b          #+#    #+#             */
+/*   Updated: 2025/11/19 18:03:50 by cmetee-b         ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+/*
+ * Décodeur PC des trames de télémétrie binaires (Module05/ex02, TELEMETRY=1)
+ *
+ * Entrée : port série (/dev/ttyUSB0), fichier de capture, ou "-" (stdin)
+ * Sortie : CSV (une ligne par jeu d'échantillons), pcap optionnel
+ *          (une trame COBS par paquet, linktype USER0), statistiques
+ *          sur stderr (CRC, trous de séquence, débit)
+ *
+ * Le format vient directement de ../telemetry.h et ../telemetry.c,
+ * compilés tels quels : firmware et décodeur ne peuvent pas diverger.
+ *
+ * Traitement en flux : fichiers mappés en mémoire (mmap), buffers de taille
+ * fixe, aucune allocation par trame.
+ */
+
+extern "C" {
+#include "../telemetry.h"
+}
+
+#include <cerrno>
+#include <csignal>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <termios.h>
+#include <unistd.h>
+
+namespace {
+
+volatile std::sig_atomic_t g_stop = 0;
+
+void on_signal(int)
+{
+    g_stop = 1;
+}
+
+double now_seconds()
+{
+    timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/* Sortie bufferisée : on formate les entiers à la main dans un grand
+ * buffer, vidé par blocs (pas de fprintf par échantillon)
+ */
+class OutBuffer
+{
+public:
+    explicit OutBuffer(FILE *file) : file_(file), len_(0) {}
+    ~OutBuffer() { flush(); }
+
+    void put(char c)
+    {
+        if (len_ == sizeof(buf_))
+            flush();
+        buf_[len_++] = c;
+    }
+
+    void put(const char *s)
+    {
+        while (*s)
+            put(*s++);
+    }
+
+    void put(const void *data, size_t n)
+    {
+        const char *p = static_cast<const char *>(data);
+
+        while (n--)
+            put(*p++);
+    }
+
+    void put_uint(uint64_t v)
+    {
+        char tmp[20];
+        int  i = 0;
+
+        do
+        {
+            tmp[i++] = static_cast<char>('0' + v % 10);
+            v /= 10;
+        } while (v);
+        while (i)
+            put(tmp[--i]);
+    }
+
+    void flush()
+    {
+        if (file_ && len_)
+            fwrite(buf_, 1, len_, file_);
+        len_ = 0;
+    }
+
+    bool enabled() const { return file_ != nullptr; }
+
+private:
+    FILE   *file_;
+    size_t  len_;
+    char    buf_[1 << 16];
+};
+
+struct Stats
+{
+    uint64_t bytes = 0;
+    uint64_t frames_ok = 0;
+    uint64_t err_cobs = 0;
+    uint64_t err_size = 0;
+    uint64_t err_crc = 0;
+    uint64_t err_oversize = 0;
+    uint64_t seq_gaps = 0;      // nombre de discontinuités
+    uint64_t frames_lost = 0;   // trames manquantes estimées
+    uint64_t sets = 0;
+    uint64_t samples = 0;
+    uint64_t device_us = 0;     // durée couverte côté carte (timestamps)
+};
+
+class Decoder
+{
+public:
+    Decoder(OutBuffer &csv, OutBuffer &pcap) : csv_(csv), pcap_(pcap)
+    {
+        if (csv_.enabled())
+            csv_.put("seq,timestamp_us,set,adc0,adc1,adc2,adc3,adc4,adc5,adc6,adc7\n");
+        if (pcap_.enabled())
+            write_pcap_header();
+    }
+
+    /* Consomme un bloc d'octets bruts, découpe sur les délimiteurs 0x00 */
+    void feed(const uint8_t *data, size_t n)
+    {
+        stats_.bytes += n;
+        while (n)
+        {
+            const void *zero = memchr(data, 0, n);
+            size_t chunk = zero ? static_cast<const uint8_t *>(zero) - data : n;
+
+            append(data, chunk);
+            data += chunk;
+            n -= chunk;
+            if (zero)
+            {
+                end_frame();
+                data++;
+                n--;
+            }
+        }
+    }
+
+    const Stats &stats() const { return stats_; }
+
+private:
+    void append(const uint8_t *data, size_t n)
+    {
+        if (overflow_)
+            return;
+        if (len_ + n > sizeof(frame_))
+        {
+            overflow_ = true;
+            return;
+        }
+        memcpy(frame_ + len_, data, n);
+        len_ += n;
+    }
+
+    void end_frame()
+    {
+        if (overflow_)
+            stats_.err_oversize++;
+        else if (len_ > 0)
+            handle_frame();
+        len_ = 0;
+        overflow_ = false;
+    }
+
+    void handle_frame()
+    {
+        uint8_t status = tlm_decode(frame_, static_cast<uint16_t>(len_), work_, &decoded_);
+
+        if (status == TLM_OK)
+        {
+            if (pcap_.enabled())
+                write_pcap_packet(decoded_.timestamp_us);
+            account(decoded_);
+            write_csv(decoded_);
+            return;
+        }
+        if (pcap_.enabled())
+            write_pcap_packet(last_ts_);
+        if (status == TLM_ERR_COBS)
+            stats_.err_cobs++;
+        else if (status == TLM_ERR_SIZE)
+            stats_.err_size++;
+        else
+            stats_.err_crc++;
+    }
+
+    void account(const t_tlm_frame &f)
+    {
+        if (have_prev_)
+        {
+            uint8_t expected = static_cast<uint8_t>(prev_seq_ + 1);
+
+            if (f.seq != expected)
+            {
+                stats_.seq_gaps++;
+                stats_.frames_lost += static_cast<uint8_t>(f.seq - expected);
+            }
+            /* Différence modulo 2^32 : gère le débordement du compteur µs */
+            stats_.device_us += static_cast<uint32_t>(f.timestamp_us - last_ts_);
+        }
+        have_prev_ = true;
+        prev_seq_ = f.seq;
+        last_ts_ = f.timestamp_us;
+        stats_.frames_ok++;
+        stats_.sets += f.count;
+        stats_.samples += static_cast<uint64_t>(f.count) * tlm_channel_count(f.channels);
+    }
+
+    void write_csv(const t_tlm_frame &f)
+    {
+        uint8_t nb = tlm_channel_count(f.channels);
+
+        if (!csv_.enabled())
+            return;
+        for (uint8_t set = 0; set < f.count; set++)
+        {
+            const uint16_t *s = f.samples + set * nb;
+
+            csv_.put_uint(f.seq);
+            csv_.put(',');
+            csv_.put_uint(f.timestamp_us);
+            csv_.put(',');
+            csv_.put_uint(set);
+            for (uint8_t ch = 0; ch < TLM_MAX_CHANNELS; ch++)
+            {
+                csv_.put(',');
+                if (f.channels & (1 << ch))
+                    csv_.put_uint(*s++);
+            }
+            csv_.put('\n');
+        }
+    }
+
+    /* pcap classique (libpcap 2.4), linktype 147 = DLT_USER0 */
+    void write_pcap_header()
+    {
+        const uint32_t magic = 0xa1b2c3d4;
+        const uint16_t major = 2, minor = 4;
+        const int32_t  zone = 0;
+        const uint32_t sigfigs = 0, snaplen = 65535, linktype = 147;
+
+        pcap_.put(&magic, 4);
+        pcap_.put(&major, 2);
+        pcap_.put(&minor, 2);
+        pcap_.put(&zone, 4);
+        pcap_.put(&sigfigs, 4);
+        pcap_.put(&snaplen, 4);
+        pcap_.put(&linktype, 4);
+    }
+
+    void write_pcap_packet(uint32_t ts_us)
+    {
+        const uint32_t sec = ts_us / 1000000, usec = ts_us % 1000000;
+        const uint32_t len = static_cast<uint32_t>(len_);
+
+        pcap_.put(&sec, 4);
+        pcap_.put(&usec, 4);
+        pcap_.put(&len, 4);
+        pcap_.put(&len, 4);
+        pcap_.put(frame_, len_);
+    }
+
+    OutBuffer   &csv_;
+    OutBuffer   &pcap_;
+    Stats        stats_;
+    uint8_t      frame_[TLM_MAX_ENCODED];
+    size_t       len_ = 0;
+    bool         overflow_ = false;
+    uint8_t      work_[TLM_MAX_RAW];
+    t_tlm_frame  decoded_;
+    bool         have_prev_ = false;
+    uint8_t      prev_seq_ = 0;
+    uint32_t     last_ts_ = 0;
+};
+
+/* Port série en mode brut 8N1 */
+int open_serial(const char *path, speed_t speed)
+{
+    int fd = open(path, O_RDONLY | O_NOCTTY);
+    termios tio;
+
+    if (fd < 0)
+        return -1;
+    if (tcgetattr(fd, &tio) == 0)
+    {
+        cfmakeraw(&tio);
+        cfsetispeed(&tio, speed);
+        cfsetospeed(&tio, speed);
+        tio.c_cc[VMIN] = 1;
+        tio.c_cc[VTIME] = 0;
+        tcsetattr(fd, TCSANOW, &tio);
+        tcflush(fd, TCIFLUSH);
+    }
+    return fd;
+}
+
+/* Lecture continue (port série, pipe, stdin) jusqu'à EOF ou Ctrl+C */
+int decode_stream(int fd, Decoder &dec)
+{
+    uint8_t buf[4096];
+
+    while (!g_stop)
+    {
+        ssize_t n = read(fd, buf, sizeof(buf));
+
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n < 0)
+        {
+            perror("read");
+            return 1;
+        }
+        if (n == 0)
+            break;
+        dec.feed(buf, static_cast<size_t>(n));
+    }
+    return 0;
+}
+
+/* Fichier de capture : mappé en mémoire et décodé en un seul passage */
+int decode_file(int fd, size_t size, Decoder &dec)
+{
+    void *map;
+
+    if (size == 0)
+        return 0;
+    map = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (map == MAP_FAILED)
+    {
+        perror("mmap");
+        return 1;
+    }
+    madvise(map, size, MADV_SEQUENTIAL);
+    dec.feed(static_cast<const uint8_t *>(map), size);
+    munmap(map, size);
+    return 0;
+}
+
+/* Génère une capture synthétique avec le même encodeur que le firmware.
+ * Tous les fault_every trames, on alterne trame supprimée / octet corrompu.
+ */
+int generate(FILE *out, unsigned long frames, unsigned long fault_every)
+{
+    t_tlm_frame f;
+    uint8_t     enc[TLM_MAX_ENCODED];
+    uint32_t    ts = 0;
+    uint16_t    phase = 0;
+
+    f.channels = 0x07;
+    for (unsigned long i = 0; i < frames; i++)
+    {
+        f.seq = static_cast<uint8_t>(i);
+        f.timestamp_us = ts;
+        f.count = TLM_SETS_PER_FRAME;
+        for (uint8_t set = 0; set < f.count; set++, phase++)
+        {
+            f.samples[set * 3 + 0] = phase & 0x03FF;                   // rampe
+            f.samples[set * 3 + 1] = (phase & 0x0200) ? 0x03FF : 0;   // carré
+            f.samples[set * 3 + 2] = 512 + (phase % 7);               // ~constant
+        }
+        ts += 500 * TLM_SETS_PER_FRAME;
+
+        uint16_t len = tlm_encode(&f, enc);
+        if (fault_every && i % fault_every == fault_every - 1)
+        {
+            if ((i / fault_every) % 2 == 0)
+                continue;
+            enc[len / 2] ^= 0x5A;
+            if (enc[len / 2] == 0)
+                enc[len / 2] = 0x5A;
+        }
+        fwrite(enc, 1, len, out);
+    }
+    return 0;
+}
+
+void print_stats(const Stats &s, double wall)
+{
+    fprintf(stderr, "--- telemetry ---\n");
+    fprintf(stderr, "bytes          %llu\n", (unsigned long long)s.bytes);
+    fprintf(stderr, "frames ok      %llu\n", (unsigned long long)s.frames_ok);
+    fprintf(stderr, "crc errors     %llu\n", (unsigned long long)s.err_crc);
+    fprintf(stderr, "cobs errors    %llu\n", (unsigned long long)s.err_cobs);
+    fprintf(stderr, "size errors    %llu\n", (unsigned long long)(s.err_size + s.err_oversize));
+    fprintf(stderr, "seq gaps       %llu (%llu frames lost)\n",
+            (unsigned long long)s.seq_gaps, (unsigned long long)s.frames_lost);
+    fprintf(stderr, "sample sets    %llu (%llu samples)\n",
+            (unsigned long long)s.sets, (unsigned long long)s.samples);
+    if (s.device_us)
+        fprintf(stderr, "device rate    %.1f sets/s over %.3f s\n",
+                s.sets * 1e6 / s.device_us, s.device_us / 1e6);
+    if (wall > 0)
+        fprintf(stderr, "decode speed   %.1f MB/s (%.3f s)\n",
+                s.bytes / wall / 1e6, wall);
+}
+
+void usage(const char *name)
+{
+    fprintf(stderr,
+            "usage: %s [-o out.csv] [-p out.pcap] [-q] <device|capture|->\n"
+            "       %s -g frames [-f fault_every] <capture>\n"
+            "  -o  CSV output (default: stdout)\n"
+            "  -p  also write every frame to a pcap file\n"
+            "  -q  no CSV, statistics only\n"
+            "  -g  generate a synthetic capture with the firmware encoder\n"
+            "  -f  with -g: drop or corrupt one frame every N frames\n",
+            name, name);
+}
+
+}  // namespace
+
+int main(int argc, char **argv)
+{
+    const char   *csv_path = nullptr;
+    const char   *pcap_path = nullptr;
+    bool          quiet = false;
+    unsigned long gen_frames = 0;
+    unsigned long fault_every = 0;
+    int           opt;
+
+    while ((opt = getopt(argc, argv, "o:p:qg:f:h")) != -1)
+    {
+        switch (opt)
+        {
+            case 'o': csv_path = optarg; break;
+            case 'p': pcap_path = optarg; break;
+            case 'q': quiet = true; break;
+            case 'g': gen_frames = strtoul(optarg, nullptr, 10); break;
+            case 'f': fault_every = strtoul(optarg, nullptr, 10); break;
+            default: usage(argv[0]); return opt == 'h' ? 0 : 2;
+        }
+    }
+    if (optind != argc - 1)
+    {
+        usage(argv[0]);
+        return 2;
+    }
+    const char *input = argv[optind];
+
+    if (gen_frames)
+    {
+        FILE *out = fopen(input, "wb");
+
+        if (!out)
+        {
+            perror(input);
+            return 1;
+        }
+        generate(out, gen_frames, fault_every);
+        fclose(out);
+        return 0;
+    }
+
+    FILE *csv_file = quiet ? nullptr : (csv_path ? fopen(csv_path, "w") : stdout);
+    FILE *pcap_file = pcap_path ? fopen(pcap_path, "wb") : nullptr;
+    if ((!quiet && !csv_file) || (pcap_path && !pcap_file))
+    {
+        perror(!csv_file ? csv_path : pcap_path);
+        return 1;
+    }
+
+    int ret;
+    double start = now_seconds();
+    Stats stats;
+    {
+        OutBuffer csv(csv_file);
+        OutBuffer pcap(pcap_file);
+        Decoder   dec(csv, pcap);
+        struct stat st;
+        int fd = strcmp(input, "-") == 0 ? STDIN_FILENO : open(input, O_RDONLY);
+
+        if (fd < 0 || fstat(fd, &st) < 0)
+        {
+            perror(input);
+            return 1;
+        }
+        if (S_ISCHR(st.st_mode) && isatty(fd))
+        {
+            close(fd);
+            fd = open_serial(input, B115200);
+            if (fd < 0)
+            {
+                perror(input);
+                return 1;
+            }
+            signal(SIGINT, on_signal);
+            ret = decode_stream(fd, dec);
+        }
+        else if (S_ISREG(st.st_mode))
+            ret = decode_file(fd, static_cast<size_t>(st.st_size), dec);
+        else
+            ret = decode_stream(fd, dec);
+        if (fd != STDIN_FILENO)
+            close(fd);
+        stats = dec.stats();
+    }
+    print_stats(stats, now_seconds() - start);
+    if (csv_file && csv_file != stdout)
+        fclose(csv_file);
+    if (pcap_file)
+        fclose(pcap_file);
+    return ret;
+}
@@ -12,28 +12,417 @@
 
 
 #include "uart.h"
+#include "telemetry.h"
+#include "scope.h"
+#include "adc_scan.h"
+#include "ntc.h"
+#include "adc_sched.h"
+
+/* Canaux lus : ADC0 (RV1), ADC1 (LDR), ADC2 (NTC) */
+#define CHANNELS        0b00000111
+#define NB_CHANNELS     3
+
+#if !SCOPE
+static const uint8_t g_channels[NB_CHANNELS] = {0, 1, 2};
+#endif
+
+#ifndef ADC_BENCH
+# define ADC_BENCH 0
+#endif
+
+#ifndef ADC_SCHED
+# define ADC_SCHED 0
+#endif
+
+#if SCOPE
+
+/* Mode oscilloscope (make SCOPE=1) : un canal échantillonné par le Timer1
+ * à cadence fixe, envoyé buffer par buffer. Avec TELEMETRY=1 chaque buffer
+ * part en trames binaires (~2.6 octets par échantillon, flux continu
+ * jusqu'à ~4400 S/s) ; en ASCII les buffers qui arrivent pendant
+ * l'envoi sont perdus et comptés par scope_overruns().
+ * Pertes visibles dans les deux modes : en ASCII le total suit chaque
+ * buffer ("perdus N"), en binaire seq saute des trames qu'auraient
+ * portées les buffers perdus et tlm_decode les compte comme une
+ * discontinuité (seq modulo 256 : un multiple de 16 buffers perdus
+ * d'un coup ne se voit pas).
+ */
+# ifndef SCOPE_CHANNEL
+#  define SCOPE_CHANNEL 0
+# endif
+# ifndef SCOPE_RATE
+#  define SCOPE_RATE    4000
+# endif
+# ifndef SCOPE_TRIGGER
+#  define SCOPE_TRIGGER SCOPE_TRIG_RISING
+# endif
+# ifndef SCOPE_LEVEL
+#  define SCOPE_LEVEL   512
+# endif
+
+int main(void)
+{
+    const volatile uint16_t *samples;
+    uint32_t    start_us;
+    uint16_t    period_us;
+    uint16_t    lost;
+# if TELEMETRY == TELEMETRY_BINARY
+    uint16_t    lost_seen = 0;
+    t_tlm_frame frame;
+    uint8_t     encoded[TLM_MAX_ENCODED];
+
+    frame.seq = 0;
+    frame.channels = (1 << SCOPE_CHANNEL);
+    frame.count = TLM_SETS_PER_FRAME;
+# endif
+
+    uart_init();
+    timer_init();
+    period_us = scope_init(SCOPE_CHANNEL, SCOPE_RATE);
+    scope_set_trigger(SCOPE_TRIGGER, SCOPE_LEVEL);
+
+    sei();
+    scope_start();
+
+    while (1)
+    {
+        samples = scope_get_buffer(&start_us);
+        if (!samples)
+            continue;
+        lost = scope_overruns();
+# if TELEMETRY == TELEMETRY_BINARY
+        /* Buffers perdus depuis le précédent : leurs trames manquent */
+        frame.seq += (uint8_t)((lost - lost_seen)
+                               * (SCOPE_BUF_SIZE / TLM_SETS_PER_FRAME));
+        lost_seen = lost;
+        for (uint8_t i = 0; i < SCOPE_BUF_SIZE; i += TLM_SETS_PER_FRAME)
+        {
+            frame.timestamp_us = start_us + (uint32_t)i * period_us;
+            for (uint8_t j = 0; j < TLM_SETS_PER_FRAME; j++)
+                frame.samples[j] = samples[i + j];
+            uart_write((const char *)encoded, tlm_encode(&frame, encoded));
+            frame.seq++;
+        }
+# else
+        (void)period_us;
+        for (uint8_t i = 0; i < SCOPE_BUF_SIZE; i++)
+        {
+            uart_printstr(printdec(samples[i]));
+            uart_printstr("\r\n");
+        }
+        uart_printstr("perdus ");
+        uart_printstr(printdec(lost));
+        uart_printstr("\r\n\r\n");
+# endif
+        scope_release();
+    }
+}
+
+#elif ADC_BENCH
+
+/* Banc de comparaison (make ADC_BENCH=1) : adc_read (attente active)
+ * contre adc_read_quiet (CPU endormi), BENCH_SAMPLES lectures du même
+ * canal chacune. Potentiomètre immobile pendant la mesure.
+ * Affiche moyenne, min, max, variance (LSB², 2 décimales) et la durée
+ * par lecture en cycles CPU, comptée par le Timer1 à F_CPU.
+ * Tous les timers synchrones s'arrêtent en SLEEP_MODE_ADC (le Timer2
+ * asynchrone demande un quartz 32kHz absent de la carte) : pour
+ * adc_read_quiet le Timer1 ne compte que le temps éveillé, auquel
+ * s'ajoute la conversion faite pendant le sommeil (13 cycles ADC, soit
+ * BENCH_CONV_CYCLES, à un cycle ADC près selon l'entrée en sommeil).
+ * BENCH_PIN est à 1 pendant chaque lecture, dans les deux modes : la
+ * latence totale se vérifie à l'oscilloscope (largeur des impulsions).
+ */
+# ifndef BENCH_CHANNEL
+#  define BENCH_CHANNEL 0
+# endif
+# define BENCH_SAMPLES  256
+# define BENCH_PIN      PB1     // LED D2, sonde de l'oscilloscope
+# define BENCH_CONV_CYCLES  (13 * 128)  // 13 cycles ADC, prescaler 128
+
+typedef struct s_bench
+{
+    uint16_t mean;
+    uint16_t min;
+    uint16_t max;
+    uint16_t var_x100;      // variance * 100
+    uint16_t cycles;        // cycles CPU éveillé par lecture (Timer1)
+} t_bench;
+
+static void bench_run(uint16_t (*read)(uint8_t), t_bench *res)
+{
+    uint32_t sum = 0;
+    uint32_t sumsq = 0;     // 256 * 1023² < 2^32
+    uint32_t cycles = 0;
+    uint16_t t0;
+    uint64_t var;
+    uint16_t v;
+
+    res->min = 0xFFFF;
+    res->max = 0;
+    for (uint16_t i = 0; i < BENCH_SAMPLES; i++)
+    {
+        PORTB |= (1 << BENCH_PIN);
+        t0 = TCNT1;
+        v = read(BENCH_CHANNEL);
+        /* Une lecture < 65536 cycles : la soustraction 16 bits suffit */
+        cycles += (uint16_t)(TCNT1 - t0);
+        PORTB &= ~(1 << BENCH_PIN);
+        sum += v;
+        sumsq += (uint32_t)v * v;
+        if (v < res->min)
+            res->min = v;
+        if (v > res->max)
+            res->max = v;
+    }
+    res->cycles = cycles / BENCH_SAMPLES;
+
+    /* var = (N * Σx² - (Σx)²) / N² */
+    var = (uint64_t)sumsq * BENCH_SAMPLES - (uint64_t)sum * sum;
+    var = var * 100 / ((uint32_t)BENCH_SAMPLES * BENCH_SAMPLES);
+    res->var_x100 = (var > 0xFFFF) ? 0xFFFF : (uint16_t)var;
+    res->mean = (sum + BENCH_SAMPLES / 2) / BENCH_SAMPLES;
+}
+
+/* asleep : la conversion s'est faite CPU endormi, hors du Timer1 */
+static void bench_print(const char *name, const t_bench *res, uint8_t asleep)
+{
+    uint16_t total = res->cycles + (asleep ? BENCH_CONV_CYCLES : 0);
+
+    uart_printstr(name);
+    uart_printstr(" moy ");
+    uart_printstr(printdec(res->mean));
+    uart_printstr(" min ");
+    uart_printstr(printdec(res->min));
+    uart_printstr(" max ");
+    uart_printstr(printdec(res->max));
+    uart_printstr(" var ");
+    uart_printstr(printdec(res->var_x100 / 100));
+    uart_tx('.');
+    uart_tx('0' + (res->var_x100 % 100) / 10);
+    uart_tx('0' + res->var_x100 % 10);
+    uart_printstr(" cycles/lecture ");
+    uart_printstr(printdec(res->cycles));
+    if (asleep)
+    {
+        uart_printstr(" eveille + ");
+        uart_printstr(printdec(BENCH_CONV_CYCLES));
+        uart_printstr(" en sommeil");
+    }
+    uart_printstr(" = ");
+    uart_printstr(printdec(total / (F_CPU / 1000000UL)));
+    uart_printstr("us\r\n");
+}
+
+int main(void)
+{
+    t_bench busy;
+    t_bench quiet;
+
+    uart_init();
+    adc_init();
+    timer_init();
+    DDRB |= (1 << BENCH_PIN);
+
+    /* Timer1 en comptage libre à F_CPU (Table 16-5, CS1 = 001), lu
+     * seulement par bench_run : il n'est pas utilisé hors mode SCOPE
+     */
+    TCCR1A = 0;
+    TCCR1B = (1 << CS10);
+
+    /* Interruptions : UART, base de temps et réveil par l'ADC */
+    sei();
+
+    while (1)
+    {
+        /* Rien en cours d'émission pendant les mesures */
+        uart_flush();
+        bench_run(adc_read, &busy);
+        bench_run(adc_read_quiet, &quiet);
+
+        bench_print("busy ", &busy, 0);
+        bench_print("quiet", &quiet, 1);
+        uart_printstr("\r\n");
+        _delay_ms(1000);
+    }
+}
+
+#elif ADC_SCHED
+
+/* Cadences par canal (make ADC_SCHED=1) : chaque capteur est lu à son
+ * rythme par l'ordonnanceur au lieu de la vitesse de la boucle.
+ * Une ligne par seconde : dernières valeurs + conversions/s
+ */
+# define SCHED_POT_MS   10      // RV1 : 100Hz
+# define SCHED_LDR_MS   100     // LDR : 10Hz
+# define SCHED_NTC_MS   1000    // NTC : 1Hz
+
+static int16_t g_ntc_centi = 0;
+
+/* Conversion en °C une fois par seconde, seulement quand la mesure arrive */
+static void ntc_done(uint8_t channel, uint16_t value)
+{
+    (void)channel;
+    g_ntc_centi = ntc_centi_celsius(value, 10);
+}
+
+int main(void)
+{
+    int8_t   pot;
+    int8_t   ldr;
+    uint32_t last_print;
+    uint32_t last_conv = 0;
+    uint32_t conv;
+    int16_t  temp;
+
+    uart_init();
+    adc_init();
+    timer_init();
+
+    /* Interruptions : UART et base de temps */
+    sei();
+
+    pot = adc_sched_add(0, SCHED_POT_MS, 0);
+    ldr = adc_sched_add(1, SCHED_LDR_MS, 0);
+    adc_sched_add(NTC_CHANNEL, SCHED_NTC_MS, ntc_done);
+    last_print = timer_millis();
+
+    while (1)
+    {
+        adc_sched_poll();
+
+        if (timer_millis() - last_print < 1000)
+            continue;
+        last_print += 1000;
+
+        uart_printstr(printdec(adc_sched_get(pot)));
+        uart_printstr(", ");
+        uart_printstr(printdec(adc_sched_get(ldr)));
+        uart_printstr(", ");
+        temp = g_ntc_centi;
+        if (temp < 0)
+        {
+            uart_tx('-');
+            temp = -temp;
+        }
+        uart_printstr(printdec(temp / 100));
+        uart_tx('.');
+        uart_tx('0' + (temp % 100) / 10);
+        uart_tx('0' + temp % 10);
+        uart_printstr("C, ");
+
+        /* 111 attendues : ~1.2% du temps ADC */
+        conv = adc_sched_conversions();
+        uart_printstr(printdec(conv - last_conv));
+        uart_printstr(" conv/s\r\n");
+        last_conv = conv;
+    }
+}
+
+#elif TELEMETRY == TELEMETRY_BINARY
+
+/* Période d'échantillonnage en mode binaire (µs)
+ * 500µs = 2000 jeux/s : une trame de 8 jeux fait 41 octets encodés,
+ * soit ~5 octets par jeu contre 18 en ASCII (~10250 octets/s sur 11520)
+ */
+# ifndef TLM_PERIOD_US
+#  define TLM_PERIOD_US 500
+# endif
+
+int main(void)
+{
+    t_tlm_frame frame;
+    uint8_t     encoded[TLM_MAX_ENCODED];
+    uint32_t    next_sample;
+
+    uart_init();
+    adc_init();
+    timer_init();
+    adc_scan_init(g_channels, NB_CHANNELS);
+
+    /* Active les interruptions : UART, base de temps et scanner ADC */
+    sei();
+
+    frame.seq = 0;
+    frame.channels = CHANNELS;
+    frame.count = 0;
+    next_sample = timer_micros();
+
+    while (1)
+    {
+        /* Cadence fixe (comparaison signée : gère le débordement 32 bits) */
+        while ((int32_t)(timer_micros() - next_sample) < 0)
+            ;
+        next_sample += TLM_PERIOD_US;
+
+        if (frame.count == 0)
+            frame.timestamp_us = timer_micros();
+        /* Dernières valeurs du scanner : lecture immédiate */
+        for (uint8_t ch = 0; ch < NB_CHANNELS; ch++)
+            frame.samples[frame.count * NB_CHANNELS + ch] = adc_scan_get(g_channels[ch]);
+
+        if (++frame.count == TLM_SETS_PER_FRAME)
+        {
+            uint16_t len = tlm_encode(&frame, encoded);
+
+            uart_write((const char *)encoded, len);
+            frame.seq++;
+            frame.count = 0;
+        }
+    }
+}
+
+#else
 
 int main(void)
 {
     uint16_t adc_value;
+    int16_t  temp;
 
     uart_init();
     adc_init();
+    adc_scan_init(g_channels, NB_CHANNELS);
+    /* NTC (lente) sur 12 bits : 16 conversions par valeur, ~5ms.
+     * RV1 et LDR restent en 10 bits bruts, une valeur par tour de scan
+     */
+    adc_scan_set_oversampling(2, 2, 1);
+
+    /* Active les interruptions : buffer d'émission UART et scanner ADC */
+    sei();
     
     while (1)
     {
-        adc_value = adc_read(0);
+        adc_value = adc_scan_get(0);
         uart_printstr(printdec(adc_value));
         uart_printstr(", ");
         
-        adc_value = adc_read(1);
+        adc_value = adc_scan_get(1);
         uart_printstr(printdec(adc_value));
         uart_printstr(", ");
         
-        adc_value = adc_read(2);
+        adc_value = adc_scan_get(2);
         uart_printstr(printdec(adc_value));
-        uart_printstr("\r\n");
+        uart_printstr(", ");
+
+        /* Température NTC en °C, 2 décimales */
+        temp = ntc_read_centi_celsius();
+        if (temp < 0)
+        {
+            uart_tx('-');
+            temp = -temp;
+        }
+        uart_printstr(printdec(temp / 100));
+        uart_tx('.');
+        uart_tx('0' + (temp % 100) / 10);
+        uart_tx('0' + temp % 10);
+        uart_printstr("C, ");
+
+        /* Alimentation mesurée (bandgap) */
+        uart_printstr(printdec(adc_vcc_mv()));
+        uart_printstr("mV\r\n");
 
         _delay_ms(20);
     }
 }
+
+#endif
@@ -0,0 +1,58 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   ntc.c                                              :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: cmetee-b <cmetee-b@student.42.fr>          +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2025/11/23 11:02:17 by cmetee-b          #+#    #+#             */
+/*   Updated: 2025/11/23 16:48:05 by cmetee-b         ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+#include "uart.h"
+#include "scope.h"
+#include "adc_scan.h"
+#include "ntc.h"
+#include "ntc_table.h"
+
+/* Bits de fraction entre deux points de la table */
+#define NTC_FRAC_BITS   (16 - NTC_TABLE_BITS)
+
+int16_t ntc_centi_celsius(uint16_t code, uint8_t bits)
+{
+    uint16_t x;
+    uint16_t idx;
+    uint16_t frac;
+    int32_t  a;
+    int32_t  b;
+    int32_t  t;
+
+    /* Code ramené en fraction 16 bits de la pleine échelle : la même
+     * table sert en 10 bits et en suréchantillonné (12, 13 bits)
+     */
+    x = code << (16 - bits);
+    idx = x >> NTC_FRAC_BITS;
+    frac = x & ((1 << NTC_FRAC_BITS) - 1);
+
+    /* Le code max (0xFFC0 en 10 bits) laisse toujours idx + 1 dans la table */
+    a = (int16_t)pgm_read_word(&ntc_table[idx]);
+    b = (int16_t)pgm_read_word(&ntc_table[idx + 1]);
+    t = a + (((b - a) * frac) >> NTC_FRAC_BITS);
+
+    if (t < NTC_T_MIN * 100)
+        return NTC_T_MIN * 100;
+    if (t > NTC_T_MAX * 100)
+        return NTC_T_MAX * 100;
+    return (int16_t)t;
+}
+
+#if !SCOPE
+
+int16_t ntc_read_centi_celsius(void)
+{
+    return ntc_centi_celsius(adc_scan_get(NTC_CHANNEL),
+                             adc_scan_bits(NTC_CHANNEL));
+}
+
+#endif
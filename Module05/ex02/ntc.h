@@ -0,0 +1,36 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   ntc.h                                              :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: cmetee-b <cmetee-b@student.42.fr>          +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2025/11/23 11:02:17 by cmetee-b          #+#    #+#             */
+/*   Updated: 2025/11/23 16:48:05 by cmetee-b         ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+#ifndef NTC_H
+#define NTC_H
+
+#include <stdint.h>
+
+/* Thermistance NTC sur ADC2 (R20)
+ * Conversion par table en flash (ntc_table.h, générée par
+ * host/gen_ntc_table.py à partir de R25/beta/R série, voir le Makefile)
+ * et interpolation linéaire entière : ~100 cycles au lieu de plusieurs
+ * milliers pour Steinhart-Hart en float.
+ */
+#define NTC_CHANNEL 2
+
+/* Température en centièmes de °C pour un code ADC de bits bits (10-16),
+ * bornée à [NTC_T_MIN, NTC_T_MAX]
+ */
+int16_t ntc_centi_celsius(uint16_t code, uint8_t bits);
+
+/* Dernière valeur du scanner sur ADC2, convertie (2512 = 25.12°C)
+ * Le canal doit être dans la liste du scanner
+ */
+int16_t ntc_read_centi_celsius(void);
+
+#endif
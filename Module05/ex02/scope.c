@@ -0,0 +1,236 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   scope.c                                            :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: cmetee-b <cmetee-b@student.42.fr>          +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2025/11/20 14:05:33 by cmetee-b          #+#    #+#             */
+/*   Updated: 2025/11/20 19:45:50 by cmetee-b         ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+#include "uart.h"
+#include "scope.h"
+
+/* Compilé seulement en mode oscilloscope (make SCOPE=1) :
+ * l'ISR ADC est alors réservée à la capture
+ */
+#if SCOPE
+
+/* États de l'ISR */
+#define STATE_WAIT_TRIGGER  0
+#define STATE_CAPTURE       1
+
+static volatile uint16_t buffers[2][SCOPE_BUF_SIZE];
+static volatile uint32_t buf_start_us[2];
+static volatile uint8_t  buf_ready = 0;     // bit n = buffers[n] plein
+static volatile uint8_t  fill_idx = 0;      // buffer rempli par l'ISR
+static volatile uint8_t  fill_pos = 0;
+static uint8_t           read_idx = 0;      // buffer lu par le main
+
+static volatile uint8_t  state = STATE_CAPTURE;
+static uint8_t           trig_mode = SCOPE_TRIG_NONE;
+static uint16_t          trig_level = 512;
+static volatile uint16_t prev_sample = 0;
+static volatile uint16_t overruns = 0;
+static uint16_t          dropped = 0;       // échantillons perdus du buffer en cours
+
+static uint8_t           timer_cs = 0;      // bits CS12:0 gardés pour scope_start
+
+uint16_t scope_init(uint8_t channel, uint16_t rate_hz)
+{
+    uint32_t ticks;
+    uint16_t prescaler;
+    uint8_t  adc_ps;
+
+    if (rate_hz < SCOPE_MIN_RATE)
+        rate_hz = SCOPE_MIN_RATE;
+    if (rate_hz > SCOPE_MAX_RATE)
+        rate_hz = SCOPE_MAX_RATE;
+
+    /* Timer1 : une période = (OCR1A + 1) * prescaler / F_CPU
+     * On prend le plus petit prescaler qui tient sur 16 bits (précision max)
+     * CS12:0 = 001 (clk/1), 010 (clk/8), 011 (clk/64) - Table 16-5
+     */
+    ticks = F_CPU / rate_hz;
+    if (ticks <= 65536UL)
+    {
+        prescaler = 1;
+        timer_cs = (1 << CS10);
+    }
+    else if (ticks / 8 <= 65536UL)
+    {
+        prescaler = 8;
+        timer_cs = (1 << CS11);
+    }
+    else
+    {
+        prescaler = 64;
+        timer_cs = (1 << CS11) | (1 << CS10);
+    }
+    ticks /= prescaler;
+
+    scope_stop();
+
+    /* Mode 4 : CTC, TOP = OCR1A (Table 16-4, WGM12 = 1)
+     * OCR1B = OCR1A : le Compare Match B tombe une fois par période
+     * et sert de source de déclenchement à l'ADC
+     */
+    TCCR1A = 0;
+    TCCR1B = (1 << WGM12);
+    OCR1A = (uint16_t)(ticks - 1);
+    OCR1B = (uint16_t)(ticks - 1);
+    TCNT1 = 0;
+
+    /* Horloge ADC (24.4 Prescaling and Conversion Timing)
+     * Conversion auto-déclenchée = 13.5 cycles ADC
+     *   /128 : 125kHz -> 9259 S/s max, 10 bits pleins
+     *   /64  : 250kHz -> 18518 S/s max, ~9 bits
+     *   /32  : 500kHz -> 37037 S/s max, ~8 bits
+     */
+    if (rate_hz <= 9200)
+        adc_ps = (1 << ADPS2) | (1 << ADPS1) | (1 << ADPS0);
+    else if (rate_hz <= 18500)
+        adc_ps = (1 << ADPS2) | (1 << ADPS1);
+    else
+        adc_ps = (1 << ADPS2) | (1 << ADPS0);
+
+    /* Référence AVCC + canal (24.9.1 ADMUX) */
+    ADMUX = (1 << REFS0) | (channel & 0x0F);
+
+    /* Entrée numérique coupée sur la broche analogique (24.9.5 DIDR0) :
+     * moins de consommation et de bruit
+     */
+    if (channel < 6)
+        DIDR0 |= (1 << channel);
+
+    /* ADTS2:0 = 101 : Timer/Counter1 Compare Match B (Table 24-6) */
+    ADCSRB = (1 << ADTS2) | (1 << ADTS0);
+
+    /* ADEN + ADATE (auto-trigger) + ADIE (interruption, vecteur 21) */
+    ADCSRA = (1 << ADEN) | (1 << ADATE) | (1 << ADIE) | adc_ps;
+
+    return (uint16_t)(((uint32_t)ticks * prescaler) / (F_CPU / 1000000UL));
+}
+
+void scope_set_trigger(uint8_t mode, uint16_t level)
+{
+    uint8_t sreg = SREG;
+
+    cli();
+    trig_mode = mode;
+    trig_level = level;
+    state = (mode == SCOPE_TRIG_NONE) ? STATE_CAPTURE : STATE_WAIT_TRIGGER;
+    fill_pos = 0;
+    dropped = 0;
+    SREG = sreg;
+}
+
+void scope_start(void)
+{
+    TCNT1 = 0;
+    TIFR1 = (1 << OCF1B);
+    TCCR1B = (1 << WGM12) | timer_cs;
+}
+
+void scope_stop(void)
+{
+    /* CS12:0 = 000 : Timer1 arrêté, plus de déclenchement */
+    TCCR1B &= ~((1 << CS12) | (1 << CS11) | (1 << CS10));
+}
+
+/* Vecteur 21 - ADC Conversion Complete */
+ISR(ADC_vect)
+{
+    uint16_t value = ADC;
+
+    /* Le déclenchement se fait sur le front montant de OCF1B : il faut
+     * l'effacer (écrire 1) pour que le prochain Compare Match relance
+     * une conversion (24.5 Starting a Conversion / 16.11.9 TIFR1)
+     */
+    TIFR1 = (1 << OCF1B);
+
+    if (state == STATE_WAIT_TRIGGER)
+    {
+        uint8_t crossed;
+
+        if (trig_mode == SCOPE_TRIG_RISING)
+            crossed = (prev_sample < trig_level && value >= trig_level);
+        else
+            crossed = (prev_sample > trig_level && value <= trig_level);
+        prev_sample = value;
+        if (!crossed)
+            return;
+        state = STATE_CAPTURE;
+    }
+
+    if (fill_pos == 0)
+    {
+        /* Les deux buffers sont pleins : le main est en retard */
+        if (buf_ready & (1 << fill_idx))
+        {
+            /* Un buffer perdu compté une fois : au premier échantillon
+             * jeté, puis tous les SCOPE_BUF_SIZE en acquisition continue
+             * (avec déclenchement, on attend le front suivant)
+             */
+            if (dropped == 0)
+                overruns++;
+            if (++dropped == SCOPE_BUF_SIZE)
+                dropped = 0;
+            if (trig_mode != SCOPE_TRIG_NONE)
+            {
+                state = STATE_WAIT_TRIGGER;
+                dropped = 0;
+            }
+            return;
+        }
+        dropped = 0;
+        buf_start_us[fill_idx] = timer_micros();
+    }
+
+    buffers[fill_idx][fill_pos++] = value;
+
+    if (fill_pos == SCOPE_BUF_SIZE)
+    {
+        buf_ready |= (1 << fill_idx);
+        fill_idx ^= 1;
+        fill_pos = 0;
+        if (trig_mode != SCOPE_TRIG_NONE)
+        {
+            state = STATE_WAIT_TRIGGER;
+            prev_sample = value;
+        }
+    }
+}
+
+const volatile uint16_t *scope_get_buffer(uint32_t *start_us)
+{
+    if (!(buf_ready & (1 << read_idx)))
+        return 0;
+    *start_us = buf_start_us[read_idx];
+    return buffers[read_idx];
+}
+
+void scope_release(void)
+{
+    uint8_t sreg = SREG;
+
+    cli();
+    buf_ready &= ~(1 << read_idx);
+    SREG = sreg;
+    read_idx ^= 1;
+}
+
+uint16_t scope_overruns(void)
+{
+    uint16_t n;
+    uint8_t sreg = SREG;
+
+    cli();
+    n = overruns;
+    SREG = sreg;
+    return n;
+}
+
+#endif
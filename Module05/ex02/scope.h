@@ -0,0 +1,63 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   scope.h                                            :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: cmetee-b <cmetee-b@student.42.fr>          +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2025/11/20 14:05:33 by cmetee-b          #+#    #+#             */
+/*   Updated: 2025/11/20 19:47:12 by cmetee-b         ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+#ifndef SCOPE_H
+#define SCOPE_H
+
+#include <stdint.h>
+
+#ifndef SCOPE
+# define SCOPE 0
+#endif
+
+/* Mode "oscilloscope" : conversions déclenchées par le Timer1 (Compare
+ * Match B, auto-trigger ADCSRB), résultats rangés par l'ISR ADC dans
+ * deux buffers alternés. Le main vide un buffer pendant que l'autre
+ * se remplit.
+ */
+#ifndef SCOPE_BUF_SIZE
+# define SCOPE_BUF_SIZE 128
+#endif
+
+/* Fréquences acceptées (Hz)
+ * Au-delà de ~9200 S/s l'horloge ADC passe au-dessus de 200kHz :
+ * la résolution effective baisse (~8 bits à 37 kS/s)
+ */
+#define SCOPE_MIN_RATE  16
+#define SCOPE_MAX_RATE  37000
+
+/* Déclenchement */
+#define SCOPE_TRIG_NONE     0   // acquisition continue
+#define SCOPE_TRIG_RISING   1   // chaque buffer commence sur un front montant
+#define SCOPE_TRIG_FALLING  2   // chaque buffer commence sur un front descendant
+
+/* Configure le canal et la cadence, retourne la période réelle en µs */
+uint16_t scope_init(uint8_t channel, uint16_t rate_hz);
+
+/* Niveau (0-1023) et front de déclenchement */
+void scope_set_trigger(uint8_t mode, uint16_t level);
+
+void scope_start(void);
+void scope_stop(void);
+
+/* Buffer plein prêt à être lu, ou 0 s'il n'y en a pas
+ * start_us reçoit l'heure (timer_micros) du premier échantillon
+ */
+const volatile uint16_t *scope_get_buffer(uint32_t *start_us);
+
+/* Rend le buffer obtenu par scope_get_buffer à l'ISR */
+void scope_release(void);
+
+/* Buffers perdus parce que le main n'avait pas fini de lire */
+uint16_t scope_overruns(void);
+
+#endif
@@ -0,0 +1,182 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   telemetry.c                                        :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: cmetee-b <cmetee-b@student.42.fr>          +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2025/11/18 10:12:41 by cmetee-b          #+#    #+#             */
+/*   Updated: 2025/11/18 16:38:55 by cmetee-b         ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+#include "telemetry.h"
+
+/* COBS (Consistent Overhead Byte Stuffing) :
+ * chaque 0x00 est remplacé par la distance jusqu'au 0x00 suivant, ce qui
+ * permet d'utiliser 0x00 comme délimiteur de trame. Après une perte
+ * d'octets, le récepteur se resynchronise au prochain 0x00.
+ */
+
+uint8_t tlm_channel_count(uint8_t channels)
+{
+    uint8_t n = 0;
+
+    while (channels)
+    {
+        n += channels & 1;
+        channels >>= 1;
+    }
+    return n;
+}
+
+uint16_t tlm_crc16(const uint8_t *data, uint16_t len)
+{
+    uint16_t crc = 0xFFFF;
+
+    while (len--)
+    {
+        crc ^= (uint16_t)(*data++) << 8;
+        for (uint8_t i = 0; i < 8; i++)
+        {
+            if (crc & 0x8000)
+                crc = (crc << 1) ^ 0x1021;
+            else
+                crc <<= 1;
+        }
+    }
+    return crc;
+}
+
+/* Taille brute (avant COBS) d'une trame */
+static uint16_t tlm_raw_size(uint8_t channels, uint8_t count)
+{
+    uint16_t bits = (uint16_t)count * tlm_channel_count(channels) * TLM_SAMPLE_BITS;
+
+    return TLM_HEADER_SIZE + (bits + 7) / 8 + TLM_CRC_SIZE;
+}
+
+/* Sérialise la trame (en-tête + échantillons 10 bits + CRC) dans raw */
+static uint16_t tlm_serialize(const t_tlm_frame *frame, uint8_t *raw)
+{
+    uint16_t nb = (uint16_t)frame->count * tlm_channel_count(frame->channels);
+    uint16_t pos = TLM_HEADER_SIZE;
+    uint32_t acc = 0;       // accumulateur de bits (LSB d'abord)
+    uint8_t  acc_bits = 0;
+    uint16_t crc;
+
+    raw[0] = frame->seq;
+    raw[1] = (uint8_t)(frame->timestamp_us);
+    raw[2] = (uint8_t)(frame->timestamp_us >> 8);
+    raw[3] = (uint8_t)(frame->timestamp_us >> 16);
+    raw[4] = (uint8_t)(frame->timestamp_us >> 24);
+    raw[5] = frame->channels;
+    raw[6] = frame->count;
+
+    for (uint16_t i = 0; i < nb; i++)
+    {
+        acc |= (uint32_t)(frame->samples[i] & 0x03FF) << acc_bits;
+        acc_bits += TLM_SAMPLE_BITS;
+        while (acc_bits >= 8)
+        {
+            raw[pos++] = (uint8_t)acc;
+            acc >>= 8;
+            acc_bits -= 8;
+        }
+    }
+    if (acc_bits)
+        raw[pos++] = (uint8_t)acc;
+
+    crc = tlm_crc16(raw, pos);
+    raw[pos++] = (uint8_t)crc;
+    raw[pos++] = (uint8_t)(crc >> 8);
+    return pos;
+}
+
+uint16_t tlm_encode(const t_tlm_frame *frame, uint8_t *out)
+{
+    uint8_t  raw[TLM_MAX_RAW];
+    uint16_t len = tlm_serialize(frame, raw);
+    uint16_t code_pos = 0;  // position de l'octet de code du bloc courant
+    uint16_t pos = 1;
+    uint8_t  code = 1;
+
+    for (uint16_t i = 0; i < len; i++)
+    {
+        if (raw[i] != 0)
+        {
+            out[pos++] = raw[i];
+            code++;
+        }
+        if (raw[i] == 0 || code == 0xFF)
+        {
+            out[code_pos] = code;
+            code_pos = pos++;
+            code = 1;
+        }
+    }
+    out[code_pos] = code;
+    out[pos++] = 0x00;      // délimiteur de fin de trame
+    return pos;
+}
+
+uint8_t tlm_decode(const uint8_t *in, uint16_t len, uint8_t *work,
+                   t_tlm_frame *frame)
+{
+    uint16_t raw_len = 0;
+    uint16_t i = 0;
+    uint16_t nb;
+    uint32_t acc = 0;
+    uint8_t  acc_bits = 0;
+    uint16_t pos = TLM_HEADER_SIZE;
+
+    /* Décodage COBS */
+    while (i < len)
+    {
+        uint8_t code = in[i++];
+
+        if (code == 0 || i + code - 1 > len)
+            return TLM_ERR_COBS;
+        for (uint8_t j = 1; j < code; j++)
+        {
+            if (in[i] == 0 || raw_len >= TLM_MAX_RAW)
+                return TLM_ERR_COBS;
+            work[raw_len++] = in[i++];
+        }
+        if (code != 0xFF && i < len)
+        {
+            if (raw_len >= TLM_MAX_RAW)
+                return TLM_ERR_COBS;
+            work[raw_len++] = 0;
+        }
+    }
+
+    if (raw_len < TLM_HEADER_SIZE + TLM_CRC_SIZE)
+        return TLM_ERR_SIZE;
+    if (work[6] > TLM_SETS_PER_FRAME
+        || tlm_raw_size(work[5], work[6]) != raw_len)
+        return TLM_ERR_SIZE;
+    if (tlm_crc16(work, raw_len - TLM_CRC_SIZE)
+        != (uint16_t)(work[raw_len - 2] | (work[raw_len - 1] << 8)))
+        return TLM_ERR_CRC;
+
+    frame->seq = work[0];
+    frame->timestamp_us = (uint32_t)work[1] | ((uint32_t)work[2] << 8)
+        | ((uint32_t)work[3] << 16) | ((uint32_t)work[4] << 24);
+    frame->channels = work[5];
+    frame->count = work[6];
+
+    nb = (uint16_t)frame->count * tlm_channel_count(frame->channels);
+    for (uint16_t s = 0; s < nb; s++)
+    {
+        while (acc_bits < TLM_SAMPLE_BITS)
+        {
+            acc |= (uint32_t)work[pos++] << acc_bits;
+            acc_bits += 8;
+        }
+        frame->samples[s] = acc & 0x03FF;
+        acc >>= TLM_SAMPLE_BITS;
+        acc_bits -= TLM_SAMPLE_BITS;
+    }
+    return TLM_OK;
+}
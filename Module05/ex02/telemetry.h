@@ -0,0 +1,86 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   telemetry.h                                        :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: cmetee-b <cmetee-b@student.42.fr>          +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2025/11/18 10:12:41 by cmetee-b          #+#    #+#             */
+/*   Updated: 2025/11/18 16:40:02 by cmetee-b         ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+#ifndef TELEMETRY_H
+#define TELEMETRY_H
+
+/* Pas d'include AVR ici : ce fichier (et telemetry.c) est aussi compilé
+ * côté PC par le décodeur, pour que les deux côtés partagent le même format.
+ */
+#include <stdint.h>
+
+/* Mode de sortie choisi à la compilation (make TELEMETRY=1) */
+#define TELEMETRY_ASCII  0
+#define TELEMETRY_BINARY 1
+#ifndef TELEMETRY
+# define TELEMETRY TELEMETRY_ASCII
+#endif
+
+/* Format d'une trame (avant encodage COBS), octets en little-endian :
+ *
+ *  [0]      seq          compteur de trames (modulo 256, détection de pertes)
+ *  [1..4]   timestamp    µs du premier jeu d'échantillons
+ *  [5]      channels     bitmap des canaux présents (bit n = ADCn)
+ *  [6]      count        nombre de jeux d'échantillons dans la trame
+ *  [7..]    samples      count * nb_canaux valeurs 10 bits, empaquetées
+ *                        bit à bit (LSB d'abord), jeu par jeu
+ *  [n-2..]  crc16        CRC-16/CCITT-FALSE de tous les octets précédents
+ *
+ * La trame est ensuite encodée en COBS (aucun 0x00 dedans) et terminée
+ * par un 0x00 qui sert de délimiteur.
+ */
+#define TLM_HEADER_SIZE     7
+#define TLM_CRC_SIZE        2
+#define TLM_MAX_CHANNELS    8
+#define TLM_SETS_PER_FRAME  8
+#define TLM_SAMPLE_BITS     10
+
+#define TLM_MAX_SAMPLES     (TLM_SETS_PER_FRAME * TLM_MAX_CHANNELS)
+#define TLM_MAX_PAYLOAD     ((TLM_MAX_SAMPLES * TLM_SAMPLE_BITS + 7) / 8)
+#define TLM_MAX_RAW         (TLM_HEADER_SIZE + TLM_MAX_PAYLOAD + TLM_CRC_SIZE)
+/* COBS : 1 octet de surcoût par bloc de 254 + délimiteur final */
+#define TLM_MAX_ENCODED     (TLM_MAX_RAW + TLM_MAX_RAW / 254 + 2)
+
+/* Codes retour de tlm_decode */
+#define TLM_OK          0
+#define TLM_ERR_COBS    1   // encodage COBS invalide
+#define TLM_ERR_SIZE    2   // trame trop courte ou taille incohérente
+#define TLM_ERR_CRC     3   // CRC faux
+
+typedef struct s_tlm_frame
+{
+    uint8_t  seq;
+    uint32_t timestamp_us;
+    uint8_t  channels;
+    uint8_t  count;
+    uint16_t samples[TLM_MAX_SAMPLES];  // [jeu * nb_canaux + canal]
+} t_tlm_frame;
+
+/* Nombre de canaux actifs dans le bitmap */
+uint8_t  tlm_channel_count(uint8_t channels);
+
+/* CRC-16/CCITT-FALSE (poly 0x1021, init 0xFFFF) */
+uint16_t tlm_crc16(const uint8_t *data, uint16_t len);
+
+/* Encode une trame dans out (TLM_MAX_ENCODED octets minimum)
+ * Retourne la taille écrite, délimiteur 0x00 compris
+ */
+uint16_t tlm_encode(const t_tlm_frame *frame, uint8_t *out);
+
+/* Décode une trame COBS (sans le délimiteur 0x00) vers frame
+ * work : zone de travail de TLM_MAX_RAW octets
+ * Retourne TLM_OK ou un code TLM_ERR_*
+ */
+uint8_t  tlm_decode(const uint8_t *in, uint16_t len, uint8_t *work,
+                    t_tlm_frame *frame);
+
+#endif
@@ -0,0 +1,71 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   timer.c                                            :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: cmetee-b <cmetee-b@student.42.fr>          +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2025/11/18 11:02:17 by cmetee-b          #+#    #+#             */
+/*   Updated: 2025/11/18 15:21:09 by cmetee-b         ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+#include "uart.h"
+
+/* Base de temps : Timer0 en mode CTC, une interruption par milliseconde
+ * (même réglage que Module04 : prescaler 64, OCR0A = 249)
+ * 16MHz / 64 = 250kHz -> 1 tick = 4µs, 250 ticks = 1ms
+ */
+#define TIMER_US_PER_TICK   4
+#define TIMER_TOP           249
+
+static volatile uint32_t tick_ms = 0;
+
+void timer_init(void)
+{
+    /* Mode 2 : CTC, TOP = OCR0A (Table 15-8 Waveform Generation Mode) */
+    TCCR0A = (1 << WGM01);
+
+    /* CS02:0 = 011 : clk/64 (Table 15-9 Clock Select) */
+    TCCR0B = (1 << CS01) | (1 << CS00);
+
+    OCR0A = TIMER_TOP;
+
+    /* OCIE0A : interruption Compare Match A (15.9.6 TIMSK0) */
+    TIMSK0 |= (1 << OCIE0A);
+}
+
+/* Vecteur 14 - TIMER0_COMPA */
+ISR(TIMER0_COMPA_vect)
+{
+    tick_ms++;
+}
+
+uint32_t timer_millis(void)
+{
+    uint32_t ms;
+    uint8_t sreg = SREG;
+
+    cli();
+    ms = tick_ms;
+    SREG = sreg;
+    return ms;
+}
+
+uint32_t timer_micros(void)
+{
+    uint32_t ms;
+    uint8_t ticks;
+    uint8_t sreg = SREG;
+
+    cli();
+    ms = tick_ms;
+    ticks = TCNT0;
+    /* Compare match arrivé mais ISR pas encore exécutée (interruptions
+     * coupées) : TCNT0 est déjà repassé à 0, la milliseconde compte
+     */
+    if ((TIFR0 & (1 << OCF0A)) && ticks < TIMER_TOP)
+        ms++;
+    SREG = sreg;
+    return ms * 1000 + (uint16_t)ticks * TIMER_US_PER_TICK;
+}
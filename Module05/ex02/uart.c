@@ -12,6 +12,16 @@
 
 #include "uart.h"
 
+/* Buffer circulaire d'émission
+ * tx_head : écrit par le programme principal (producteur)
+ * tx_tail : avancé par l'ISR USART_UDRE (consommateur)
+ * Buffer vide quand head == tail, plein quand head + 1 == tail
+ */
+static volatile char    tx_buf[UART_TX_SIZE];
+static volatile uint8_t tx_head = 0;
+static volatile uint8_t tx_tail = 0;
+static volatile uint16_t tx_overflows = 0;
+static volatile uint8_t tx_started = 0;     // au moins un octet envoyé
 
 void uart_init(void)
 {
@@ -46,11 +56,107 @@ void uart_init(void)
     UCSR0C = (1 << UCSZ01) | (1 << UCSZ00);
 }
 
+/* Envoie l'octet le plus ancien du buffer (appelé avec UDR0 vide) */
+static void uart_tx_next(void)
+{
+    /* TXC0 est effacé en écrivant 1 (20.11.2) : uart_flush s'en sert.
+     * Écriture directe (pas de |=) : FE0/DOR0/UPE0 doivent être écrits à 0
+     */
+    UCSR0A = (1 << U2X0) | (1 << TXC0);
+    UDR0 = tx_buf[tx_tail];
+    tx_tail = (tx_tail + 1) & UART_TX_MASK;
+    tx_started = 1;
+}
+
+/* Vecteur 19 - USART_UDRE (Table 12-6 Reset and Interrupt Vectors)
+ * Appelé tant que UDR0 est vide et UDRIE0 actif : on envoie l'octet
+ * suivant, puis on coupe l'interruption quand le buffer est vide
+ * (sinon l'ISR serait rappelée en boucle, 20.11.3 Bit 5 – UDRIEn)
+ */
+ISR(USART_UDRE_vect)
+{
+    if (tx_head == tx_tail)
+        UCSR0B &= ~(1 << UDRIE0);
+    else
+        uart_tx_next();
+}
+
+/* Ajoute un octet dans le buffer, retourne 0 si l'octet est perdu */
+static uint8_t uart_tx_push(char c)
+{
+    uint8_t next = (tx_head + 1) & UART_TX_MASK;
+
+    while (next == tx_tail)
+    {
+#if UART_TX_POLICY == UART_TX_DROP
+        tx_overflows++;
+        return 0;
+#elif UART_TX_POLICY == UART_TX_OVERWRITE
+        /* tx_tail appartient à l'ISR : section critique (SREG sauvegardé) */
+        uint8_t sreg = SREG;
+        cli();
+        if (next == tx_tail)
+        {
+            tx_tail = (tx_tail + 1) & UART_TX_MASK;
+            tx_overflows++;
+        }
+        SREG = sreg;
+#else
+        /* Interruptions coupées : l'ISR ne videra jamais le buffer,
+         * on envoie donc nous-mêmes l'octet le plus ancien (polling)
+         */
+        if (!(SREG & (1 << SREG_I)) && (UCSR0A & (1 << UDRE0)))
+            uart_tx_next();
+#endif
+    }
+    tx_buf[tx_head] = c;
+    tx_head = next;
+
+    /* (Re)lance l'ISR : elle se déclenche dès que UDR0 est vide */
+    UCSR0B |= (1 << UDRIE0);
+    return 1;
+}
+
 void uart_tx(char c)
 {
-    while (!(UCSR0A & (1 << UDRE0)));
-    
-    UDR0 = c;
+    uart_tx_push(c);
+}
+
+uint8_t uart_write(const char *buf, uint8_t len)
+{
+    uint8_t sent = 0;
+
+    while (sent < len)
+    {
+        if (!uart_tx_push(buf[sent]))
+            break;
+        sent++;
+    }
+    return sent;
+}
+
+void uart_flush(void)
+{
+    while (tx_head != tx_tail)
+    {
+        if (!(SREG & (1 << SREG_I)) && (UCSR0A & (1 << UDRE0)))
+            uart_tx_next();
+    }
+    /* Dernier octet sorti du registre à décalage (TXC0, 20.6.3) */
+    if (tx_started)
+        while (!(UCSR0A & (1 << TXC0)))
+            ;
+}
+
+uint16_t uart_tx_overflows(void)
+{
+    uint16_t n;
+    uint8_t sreg = SREG;
+
+    cli();
+    n = tx_overflows;
+    SREG = sreg;
+    return n;
 }
 
 void uart_printstr(const char *str)
@@ -59,7 +165,7 @@ void uart_printstr(const char *str)
         uart_tx(*str++);
 }
 
-// Conversion et affichage d'un nbr en décimal (0-1023 -> ADC 10 bits)
+// Conversion et affichage d'un nbr en décimal (0-9999 -> ADC 10 à 13 bits)
 char* printdec(uint16_t value)
 {
    static char str[5] = {0};                       // 4 caractères + '\0'
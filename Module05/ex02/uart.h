@@ -19,22 +19,67 @@
 
 # define UART_BAUDRATE 115200
 
+/* Buffer circulaire d'émission (vidé par l'interruption USART_UDRE)
+ * UART_TX_SIZE doit être une puissance de 2 (index masqué, pas de modulo)
+ */
+# ifndef UART_TX_SIZE
+#  define UART_TX_SIZE 64
+# endif
+# define UART_TX_MASK (UART_TX_SIZE - 1)
+# if (UART_TX_SIZE & UART_TX_MASK) || UART_TX_SIZE > 256
+#  error "UART_TX_SIZE doit être une puissance de 2 <= 256"
+# endif
+
+/* Politique quand le buffer est plein (-DUART_TX_POLICY=... dans CFLAGS)
+ * BLOCK     : attend qu'une place se libère (aucune perte)
+ * DROP      : jette le nouvel octet
+ * OVERWRITE : écrase l'octet le plus ancien encore en attente
+ */
+# define UART_TX_BLOCK      0
+# define UART_TX_DROP       1
+# define UART_TX_OVERWRITE  2
+# ifndef UART_TX_POLICY
+#  define UART_TX_POLICY UART_TX_BLOCK
+# endif
+
 /* Initialisation de l'UART */
 void uart_init(void);
 
-/* Transmission d'un caractère via UART */
+/* Transmission d'un caractère via UART (mis en file, retour immédiat) */
 void uart_tx(char c);
 
+/* Met len octets en file d'émission, retourne le nombre d'octets acceptés */
+uint8_t uart_write(const char *buf, uint8_t len);
+
+/* Attend que le buffer et le registre à décalage soient vides */
+void uart_flush(void);
+
+/* Nombre d'octets perdus/écrasés depuis le démarrage (DROP / OVERWRITE) */
+uint16_t uart_tx_overflows(void);
+
 /* Conversion et affichage en décimal */
 char* printdec(uint16_t value);
 
 /* Transmission d'une chaîne de caractères via UART */
 void uart_printstr(const char* str);
 
+/* Base de temps (Timer0, tick 1ms) */
+void timer_init(void);
+uint32_t timer_millis(void);
+uint32_t timer_micros(void);
+
 /* Initialisation de l'ADC */
 void adc_init(void);
 
 /* Lecture de l'ADC */
 uint16_t adc_read(uint8_t channel);
 
+/* Lecture en mode ADC Noise Reduction : le CPU dort pendant la conversion
+ * (moins de bruit numérique, moins de consommation)
+ * Vide d'abord le buffer UART ; le Timer0 est arrêté pendant le sommeil,
+ * timer_millis() prend ~105µs de retard par lecture.
+ * Scanner arrêté (comme pour adc_read), pas disponible en mode SCOPE.
+ */
+uint16_t adc_read_quiet(uint8_t channel);
+
 #endif
\ No newline at end of file
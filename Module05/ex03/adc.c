@@ -14,17 +14,37 @@
 
 // https://ww1.microchip.com/downloads/en/DeviceDoc/Atmel-7810-Automotive-Microcontrollers-ATmega328P_Datasheet.pdf
 // p.215
-// Constantes calculées depuis Table 23-2
+// Constantes calculées depuis Table 23-2 (valeurs par défaut si l'EEPROM
+// ne contient pas de calibration, voir calib.c)
 #define TEMP_OFFSET_0C  320   // TOS : valeur ADC à 0°C (calculée)
 #define TEMP_GAIN_x100  128   // k × 100 : 1.28 LSB/°C
 
+/* Référence 1.1V (REFS[1:0] = 11) + canal 8 (MUX[3:0] = 1000) */
+#define TEMP_ADMUX      ((1 << REFS1) | (1 << REFS0) | 0x08)
+
+/* Valeurs typiques : offset en 1/16 de LSB, gain en centièmes de °C par
+ * LSB × 256 (100 / 1.28 × 256 = 20000)
+ */
+#define TEMP_CAL_DEFAULT \
+    {TEMP_CAL_MAGIC, TEMP_OFFSET_0C * 16, \
+     (uint16_t)(100UL * 100 * 256 / TEMP_GAIN_x100), 0}
+
+const t_temp_cal g_temp_cal_default = TEMP_CAL_DEFAULT;
+
+/* Coefficients utilisés par convert_to_celsius (temp_cal_load les
+ * remplace par ceux de l'EEPROM au démarrage)
+ */
+t_temp_cal       g_temp_cal = TEMP_CAL_DEFAULT;
+
 void adc_init(void)
 {
     /* Configuration de la référence interne 1.1V (Table 23-3 p.217)
      * REFS[1:0] = 11 : Internal 1.1V Voltage Reference
      * Nécessaire pour le capteur de température
+     * Le canal 8 est sélectionné tout de suite et ne change plus :
+     * les lectures suivantes n'ont pas à attendre la référence
      */
-    ADMUX = (1 << REFS1) | (1 << REFS0);
+    ADMUX = TEMP_ADMUX;
     
     /* Activation de l'ADC (Bit 7 – ADEN: ADC Enable p.218)
      */
@@ -38,19 +58,28 @@ void adc_init(void)
     /* Délai pour stabilisation de la référence interne */
     _delay_ms(2);
 
+    /* Première conversion jetée (moins précise après changement de
+     * référence, 23.5.2)
+     */
+    ADCSRA |= (1 << ADSC);
+    while (ADCSRA & (1 << ADSC));
 }
 
 uint16_t adc_read_temp(void)
 {
     /* Sélection du canal de température (Table 23-4, page 218)
      * MUX[3:0] = 1000 : Temperature Sensor (ADC8)
+     * Seulement si quelqu'un a changé ADMUX depuis adc_init : sinon la
+     * référence est déjà stable, pas de délai ni de conversion jetée
      */
-    ADMUX = (ADMUX & 0xF0) | 0x08;  // Canal 8 = capteur température
-    
-    /* Attendre que le multiplexeur se stabilise
-     * "The first conversion result may be less accurate"
-     */
-    _delay_us(100);
+    if (ADMUX != TEMP_ADMUX)
+    {
+        ADMUX = TEMP_ADMUX;
+        /* "The first conversion result may be less accurate" */
+        _delay_us(100);
+        ADCSRA |= (1 << ADSC);
+        while (ADCSRA & (1 << ADSC));
+    }
     
     /* Démarrer la conversion */
     ADCSRA |= (1 << ADSC);
@@ -62,12 +91,33 @@ uint16_t adc_read_temp(void)
     return ADC;
 }
 
+/* Somme de 16 conversions : valeur ADC en 1/16 de LSB (~1.7ms)
+ * Le bruit du capteur (~1 LSB) est moyenné, même échelle que la
+ * calibration
+ */
+uint16_t adc_read_temp_x16(void)
+{
+    uint16_t sum = 0;
+
+    for (uint8_t i = 0; i < 16; i++)
+        sum += adc_read_temp();
+    return sum;
+}
+
+/* Température en centièmes de °C avec les coefficients courants :
+ * T = (ADC×16 - offset×16) × gain / 4096
+ * gain en centièmes de °C par LSB × 256 (256 × 16 = 4096)
+ */
+int16_t temp_read_centi(void)
+{
+    int32_t diff = (int32_t)adc_read_temp_x16() - g_temp_cal.offset_x16;
+
+    return (int16_t)((diff * g_temp_cal.gain_q8) / 4096);
+}
 
 // p.215
 int16_t convert_to_celsius(void)
 {
-    uint16_t adc_value = adc_read_temp();
-    
     /* Formule selon Table 23-2 Valeurs ADC typiques :
      * 
      * -40°C  → 0x010D (269 décimal)
@@ -92,26 +142,14 @@ int16_t convert_to_celsius(void)
      * T = (ADC - TOS) / k
      * T = (ADC - 320) / 1.28
      * 
-     * En arithmétique entière :
-     * T = ((ADC - 320) × 100) / 128
-     * 
      * NB :
-     * Ces valeurs sont typiques et varient d'une puce à l'autre.
-     * La datasheet mentionne (Section 23.8.1, page 215) :
-     * "Calibration values determined during test are available 
-     *  in the signature row"
-     * 
-     * Pour une précision optimale (±1°C), il faudrait :
-     * 1. Lire TS_GAIN et TS_OFFSET depuis la signature row
-     * 2. Utiliser la formule de calibration d'usine
-     * 
-     * Formule avec calibration d'usine :
-     * T = (((ADCH << 8) + ADCL) - (273 + 100 - TS_OFFSET)) × 128 / TS_GAIN + 25
-     * 
-     * Pour cet exercice, nous utilisons les valeurs typiques.
+     * Ces valeurs sont typiques et varient d'une puce à l'autre
+     * (Section 23.8.1, page 215). Elles ne servent que tant que la puce
+     * n'a pas été calibrée : la calibration en deux points (calib.c)
+     * mesure TOS et k sur cette puce et les garde en EEPROM.
      */
-    
-    int32_t temp = ((int32_t)(adc_value - TEMP_OFFSET_0C) * 100) / TEMP_GAIN_x100;
-    
-    return (int16_t)temp;
+    int16_t centi = temp_read_centi();
+
+    // Arrondi au degré le plus proche
+    return (centi >= 0) ? (centi + 50) / 100 : (centi - 50) / 100;
 }
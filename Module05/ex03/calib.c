@@ -0,0 +1,108 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   calib.c                                            :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: cmetee-b <cmetee-b@student.42.fr>          +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2025/11/24 09:47:12 by cmetee-b          #+#    #+#             */
+/*   Updated: 2025/11/24 14:21:36 by cmetee-b         ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+#include "uart.h"
+#include <avr/eeprom.h>
+#include <stddef.h>
+
+/* Section 23.8.1 : offset et pente du capteur varient d'une puce à
+ * l'autre (plusieurs °C d'écart avec les valeurs typiques). On les
+ * mesure sur la puce à deux températures connues :
+ *   T1 = (A1 - TOS) / k   et   T2 = (A2 - TOS) / k
+ *   => 1/k = (T2 - T1) / (A2 - A1),  TOS = A1 - T1 × k
+ */
+
+/* Écart minimum entre les deux points (1/16 LSB) : ~6°C */
+#define CAL_MIN_SPAN    (8 * 16)
+
+/* Gain accepté : 0.5 à 2.5 LSB/°C (datasheet : ~1 à 1.3) */
+#define CAL_GAIN_MIN    (100UL * 256 / 5 * 2)   // 100 / 2.5 × 256
+#define CAL_GAIN_MAX    (100UL * 256 * 2)       // 100 / 0.5 × 256
+
+static t_temp_cal EEMEM ee_temp_cal;
+
+static uint16_t cal_raw[2];         // ADC×16 mesuré à chaque point
+static int16_t  cal_centi[2];       // température de référence
+static uint8_t  cal_set = 0;        // bit n : point n noté
+
+static uint8_t temp_cal_checksum(const t_temp_cal *cal)
+{
+    const uint8_t *p = (const uint8_t *)cal;
+    uint8_t        sum = 0;
+
+    for (uint8_t i = 0; i < offsetof(t_temp_cal, checksum); i++)
+        sum += p[i];
+    return ~sum;
+}
+
+uint8_t temp_cal_load(void)
+{
+    t_temp_cal cal;
+
+    eeprom_read_block(&cal, &ee_temp_cal, sizeof(cal));
+    /* EEPROM vierge (0xFF partout) ou écriture interrompue */
+    if (cal.magic != TEMP_CAL_MAGIC || cal.checksum != temp_cal_checksum(&cal))
+    {
+        g_temp_cal = g_temp_cal_default;
+        return 0;
+    }
+    g_temp_cal = cal;
+    return 1;
+}
+
+void temp_cal_reset(void)
+{
+    g_temp_cal = g_temp_cal_default;
+    cal_set = 0;
+    /* Magic effacé : la prochaine lecture retombe sur les valeurs typiques */
+    eeprom_update_word(&ee_temp_cal.magic, 0xFFFF);
+}
+
+uint8_t temp_cal_point(uint8_t n, int16_t centi)
+{
+    uint32_t sum = 0;
+    int32_t  span;
+    int32_t  gain;
+
+    n &= 1;
+    /* 4 × 16 conversions : bruit moyenné, résultat en 1/16 de LSB */
+    for (uint8_t i = 0; i < 4; i++)
+        sum += adc_read_temp_x16();
+    cal_raw[n] = (sum + 2) / 4;
+    cal_centi[n] = centi;
+    cal_set |= (1 << n);
+    if (cal_set != 0b11)
+        return TEMP_CAL_PENDING;
+
+    span = (int32_t)cal_raw[1] - cal_raw[0];
+    if (span > -CAL_MIN_SPAN && span < CAL_MIN_SPAN)
+        return TEMP_CAL_ERR;
+
+    /* gain = (T2 - T1) / (A2 - A1) en centièmes de °C par LSB × 256,
+     * A en 1/16 de LSB : × 256 × 16
+     */
+    gain = ((int32_t)cal_centi[1] - cal_centi[0]) * 4096 / span;
+    if (gain < (int32_t)CAL_GAIN_MIN || gain > (int32_t)CAL_GAIN_MAX)
+        return TEMP_CAL_ERR;
+
+    /* TOS = A1 - T1 / gain */
+    g_temp_cal.magic = TEMP_CAL_MAGIC;
+    g_temp_cal.gain_q8 = (uint16_t)gain;
+    g_temp_cal.offset_x16 = (int16_t)((int32_t)cal_raw[0]
+                            - (int32_t)cal_centi[0] * 4096 / gain);
+    g_temp_cal.checksum = temp_cal_checksum(&g_temp_cal);
+
+    /* update : seuls les octets qui changent sont écrits (usure) */
+    eeprom_update_block(&g_temp_cal, &ee_temp_cal, sizeof(g_temp_cal));
+    cal_set = 0;
+    return TEMP_CAL_DONE;
+}
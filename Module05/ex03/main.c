@@ -12,21 +12,166 @@
 
 #include "uart.h"
 
+/* Calibration depuis le terminal (ligne terminée par Entrée) :
+ *   1 23.50   point 1 : la puce est à 23.50°C (thermomètre de référence)
+ *   2 45.00   point 2, à une autre température (au moins ~6°C d'écart)
+ *   d         retour aux valeurs typiques de la datasheet
+ *   ?         affiche les coefficients
+ */
+#define LINE_SIZE       16
+#define PRINT_PERIOD_MS 500
+
+/* Affiche des centièmes : 2345 -> "23.45" */
+static void print_centi(int16_t centi)
+{
+    if (centi < 0)
+    {
+        uart_tx('-');
+        centi = -centi;
+    }
+    uart_printstr(int_to_str(centi / 100));
+    uart_tx('.');
+    uart_tx('0' + (centi % 100) / 10);
+    uart_tx('0' + centi % 10);
+}
+
+/* Consigne lue au clavier : -150.00 à 150.00 degrés */
+#define CENTI_MAX 15000
+
+/* "-12.5" -> -1250, retourne 0 si le texte n'est pas un nombre
+ * ou sort de +-CENTI_MAX
+ */
+static uint8_t parse_centi(const char *s, int16_t *centi)
+{
+    int32_t value = 0;
+    int8_t  decimals = -1;      // -1 : pas encore de point
+    uint8_t neg = 0;
+    uint8_t digits = 0;
+
+    if (*s == '-')
+    {
+        neg = 1;
+        s++;
+    }
+    for (; *s; s++)
+    {
+        if (*s == '.' && decimals < 0)
+            decimals = 0;
+        /* value < 3000 : borne le nombre de chiffres, pas la valeur */
+        else if (*s >= '0' && *s <= '9' && decimals < 2 && value < 3000)
+        {
+            value = value * 10 + (*s - '0');
+            digits++;
+            if (decimals >= 0)
+                decimals++;
+        }
+        else
+            return 0;
+    }
+    if (digits == 0)
+        return 0;
+    if (decimals < 0)
+        decimals = 0;
+    while (decimals++ < 2)
+        value *= 10;
+    if (value > CENTI_MAX)
+        return 0;
+    *centi = (int16_t)(neg ? -value : value);
+    return 1;
+}
+
+static void handle_command(const char *line)
+{
+    int16_t centi;
+
+    if ((line[0] == '1' || line[0] == '2') && line[1] == ' ')
+    {
+        if (!parse_centi(line + 2, &centi))
+        {
+            uart_printstr("temperature invalide\r\n");
+            return;
+        }
+        switch (temp_cal_point(line[0] - '1', centi))
+        {
+            case TEMP_CAL_PENDING:
+                uart_printstr("point note\r\n");
+                break;
+            case TEMP_CAL_DONE:
+                uart_printstr("calibration sauvee en EEPROM\r\n");
+                break;
+            default:
+                uart_printstr("erreur : points trop proches ou incoherents\r\n");
+        }
+    }
+    else if (line[0] == 'd' && line[1] == '\0')
+    {
+        temp_cal_reset();
+        uart_printstr("valeurs typiques\r\n");
+    }
+    else if (line[0] == '?' && line[1] == '\0')
+    {
+        /* TOS en LSB et k en LSB/°C, 2 décimales */
+        uart_printstr("TOS ");
+        print_centi((int16_t)((int32_t)g_temp_cal.offset_x16 * 100 / 16));
+        uart_printstr(", k ");
+        print_centi((int16_t)(100UL * 100 * 256 / g_temp_cal.gain_q8));
+        uart_printstr(" LSB/C\r\n");
+    }
+    else if (line[0])
+        uart_printstr("commandes : 1 <T>, 2 <T>, d, ?\r\n");
+}
+
 int main(void)
 {
-    int16_t temp;
+    char     line[LINE_SIZE];
+    uint8_t  len = 0;
+    uint16_t elapsed = 0;
     
     uart_init();
     adc_init();
+
+    if (temp_cal_load())
+        uart_printstr("calibration EEPROM chargee\r\n");
+    else
+        uart_printstr("pas de calibration : valeurs typiques\r\n");
     
     while (1)
     {
-        temp = convert_to_celsius();
+        /* Réception scrutée toutes les ms (un caractère tapé à la main
+         * n'a pas le temps d'être écrasé)
+         */
+        if (uart_rx_ready())
+        {
+            char c = uart_rx();
+
+            if (c == '\r' || c == '\n')
+            {
+                uart_printstr("\r\n");
+                line[len] = '\0';
+                handle_command(line);
+                len = 0;
+            }
+            else if ((c == '\b' || c == 127) && len > 0)
+            {
+                len--;
+                uart_printstr("\b \b");
+            }
+            else if (c >= ' ' && len < LINE_SIZE - 1)
+            {
+                line[len++] = c;
+                uart_tx(c);
+            }
+        }
 
-        uart_printstr(int_to_str(temp));
-        uart_printstr("\r\n");
+        /* Pas d'affichage pendant la saisie d'une commande */
+        if (++elapsed >= PRINT_PERIOD_MS && len == 0)
+        {
+            print_centi(temp_read_centi());
+            uart_printstr("C\r\n");
+            elapsed = 0;
+        }
         
-        _delay_ms(20);
+        _delay_ms(1);
     }
     
     return 0;
@@ -24,7 +24,7 @@ void uart_init(void)
     UCSR0A = (1 << U2X0);                           // Mode double vitesse (p.182)
     UBRR0H = (unsigned int)(ubrr >> 8);
     UBRR0L = (unsigned char)ubrr;                   // Baudrate (p.183)
-    UCSR0B = (1 << TXEN0);                          // Activer TX (p.182)
+    UCSR0B = (1 << TXEN0) | (1 << RXEN0);           // Activer TX et RX (p.182)
     UCSR0C = (1 << UCSZ01) | (1 << UCSZ00);         // Format 8N1 (p.184)
 }
 
@@ -34,6 +34,17 @@ void uart_tx(char c)
     UDR0 = c;
 }
 
+uint8_t uart_rx_ready(void)
+{
+    return (UCSR0A & (1 << RXC0)) != 0;
+}
+
+char uart_rx(void)
+{
+    while (!(UCSR0A & (1 << RXC0)));                // Attendre un octet
+    return UDR0;
+}
+
 void uart_printstr(const char *str)
 {
     while (*str)
@@ -25,6 +25,12 @@ void uart_tx(char c);
 
 void uart_printstr(const char* str);
 
+/* Réception (scrutation) : 1 si un octet attend dans UDR0 */
+uint8_t uart_rx_ready(void);
+
+/* Lit un octet (attend qu'il arrive) */
+char uart_rx(void);
+
 /* Conversion d'un nombre signé en string (pour temp négative) */
 char* int_to_str(int16_t value);
 
@@ -34,7 +40,48 @@ void adc_init(void);
 /* Lecture brute du capteur de température */
 uint16_t adc_read_temp(void);
 
+/* Somme de 16 lectures (valeur en 1/16 de LSB) */
+uint16_t adc_read_temp_x16(void);
+
 /* Conversion en degrés Celsius */
 int16_t convert_to_celsius(void);
 
+/* Température en centièmes de °C (2345 = 23.45°C) */
+int16_t temp_read_centi(void);
+
+/* Calibration en deux points du capteur interne (calib.c)
+ * T = (ADC×16 - offset_x16) × gain_q8 / 4096, en centièmes de °C
+ * Gardée en EEPROM avec un octet de contrôle
+ */
+# define TEMP_CAL_MAGIC     0x7C41
+
+typedef struct s_temp_cal
+{
+    uint16_t magic;
+    int16_t  offset_x16;    // ADC à 0°C, en 1/16 de LSB
+    uint16_t gain_q8;       // centièmes de °C par LSB, × 256
+    uint8_t  checksum;      // complément de la somme des octets précédents
+} t_temp_cal;
+
+extern const t_temp_cal g_temp_cal_default;
+extern t_temp_cal       g_temp_cal;
+
+/* Résultats de temp_cal_point */
+# define TEMP_CAL_PENDING   0   // point noté, il manque l'autre
+# define TEMP_CAL_DONE      1   // deux points : coefficients calculés et sauvés
+# define TEMP_CAL_ERR       2   // points trop proches ou gain incohérent
+
+/* Charge les coefficients de l'EEPROM (valeurs typiques si absents ou
+ * corrompus), retourne 1 si la puce est calibrée
+ */
+uint8_t temp_cal_load(void);
+
+/* Mesure le capteur pour le point n (0 ou 1) à la température de
+ * référence centi (centièmes de °C, lue sur un thermomètre)
+ */
+uint8_t temp_cal_point(uint8_t n, int16_t centi);
+
+/* Efface la calibration : retour aux valeurs typiques */
+void temp_cal_reset(void);
+
 #endif
\ No newline at end of file
@@ -0,0 +1,131 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   filter.c                                           :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: cmetee-b <cmetee-b@student.42.fr>          +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2025/11/22 10:12:40 by cmetee-b          #+#    #+#             */
+/*   Updated: 2025/11/22 15:38:21 by cmetee-b         ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+#include "filter.h"
+
+uint16_t filter_box_update(t_box *f, uint16_t x)
+{
+    uint8_t len = 1 << f->shift;
+
+    /* Fenêtre pleine : le plus ancien sort de la somme */
+    if (f->n == len)
+        f->sum -= f->buf[f->pos];
+    else
+        f->n++;
+    f->buf[f->pos] = x;
+    f->sum += x;
+    f->pos = (f->pos + 1) & (len - 1);
+
+    if (f->n == len)
+        return f->sum >> f->shift;
+    /* Démarrage seulement : vraie division */
+    return f->sum / f->n;
+}
+
+/* acc / 2^shift arrondi au plus proche */
+static uint16_t filter_ema_round(const t_ema *f)
+{
+    if (f->shift == 0)
+        return (uint16_t)f->acc;
+    return (f->acc + ((uint32_t)1 << (f->shift - 1))) >> f->shift;
+}
+
+uint16_t filter_ema_update(t_ema *f, uint16_t x)
+{
+    if (!f->ready)
+    {
+        f->acc = (uint32_t)x << f->shift;
+        f->ready = 1;
+    }
+    else
+    {
+        /* acc += x - y, avec y = sortie précédente arrondie : tronquer
+         * ici laisserait acc bloqué quelques LSB au-dessus de la cible
+         */
+        f->acc = f->acc - filter_ema_round(f) + x;
+    }
+    return filter_ema_round(f);
+}
+
+uint16_t filter_median3(uint16_t a, uint16_t b, uint16_t c)
+{
+    if (a > b)
+    {
+        uint16_t t = a;
+
+        a = b;
+        b = t;
+    }
+    /* a <= b */
+    if (c <= a)
+        return a;
+    if (c >= b)
+        return b;
+    return c;
+}
+
+/* Échanges pour la médiane de 5 */
+#define SORT2(a, b) \
+    do { if ((a) > (b)) { uint16_t t_ = (a); (a) = (b); (b) = t_; } } while (0)
+#define SWAP_PAIRS(a, b, c, d) \
+    do { uint16_t t_ = (a); (a) = (c); (c) = t_; \
+         t_ = (b); (b) = (d); (d) = t_; } while (0)
+
+uint16_t filter_median_update(t_median *f, uint16_t x)
+{
+    uint16_t a, b, c, d, e;
+
+    if (!f->ready)
+    {
+        for (uint8_t i = 0; i < f->len; i++)
+            f->buf[i] = x;
+        f->ready = 1;
+    }
+    f->buf[f->pos] = x;
+    if (++f->pos >= f->len)
+        f->pos = 0;
+
+    if (f->len < 5)
+        return filter_median3(f->buf[0], f->buf[1], f->buf[2]);
+
+    /* Médiane de 5 en 6 comparaisons, sans trier toute la fenêtre */
+    a = f->buf[0];
+    b = f->buf[1];
+    c = f->buf[2];
+    d = f->buf[3];
+    e = f->buf[4];
+    SORT2(a, b);
+    SORT2(d, e);
+    /* Paires échangées pour avoir a <= d : a est alors plus petit que
+     * b, d et e, il ne peut pas être la médiane
+     */
+    if (a > d)
+        SWAP_PAIRS(a, b, d, e);
+    /* Même chose sur {b, c, d, e} : après tri de (b, c) et b <= d,
+     * b est éliminé, la médiane est le plus petit de c et d
+     */
+    SORT2(b, c);
+    if (b > d)
+        SWAP_PAIRS(b, c, d, e);
+    return (c < d) ? c : d;
+}
+
+uint8_t filter_hyst_update(t_hyst *f, uint16_t x)
+{
+    /* Montée : seuil franchi */
+    while (f->level < f->count && x >= f->thr[f->level])
+        f->level++;
+    /* Descente : il faut passer sous le seuil moins la bande */
+    while (f->level > 0 && (uint32_t)x + f->band < f->thr[f->level - 1])
+        f->level--;
+    return f->level;
+}
@@ -0,0 +1,100 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   filter.h                                           :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: cmetee-b <cmetee-b@student.42.fr>          +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2025/11/22 10:12:40 by cmetee-b          #+#    #+#             */
+/*   Updated: 2025/11/22 15:38:21 by cmetee-b         ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+#ifndef FILTER_H
+#define FILTER_H
+
+#include <stdint.h>
+
+/* Filtres entiers pour les capteurs (ADC 10 bits, AHT20 ramené à 16 bits)
+ * Pas de float, pas de division dans le cas normal : quelques dizaines
+ * de cycles par échantillon. Les tailles sont fixées à la compilation.
+ */
+
+/* ---- Moyenne glissante (box-car) ----
+ * 2^shift derniers échantillons, somme entretenue : à chaque mise à jour
+ * on ajoute le nouveau et on retire le plus ancien.
+ * Le buffer est déclaré avec le filtre :
+ *     FILTER_BOX(pot, 3);     // moyenne sur 8 échantillons
+ */
+typedef struct s_box
+{
+    uint16_t *buf;
+    uint32_t  sum;
+    uint8_t   shift;        // longueur = 2^shift
+    uint8_t   pos;
+    uint8_t   n;            // échantillons reçus (jusqu'à 2^shift)
+} t_box;
+
+#define FILTER_BOX(name, shift) \
+    static uint16_t name##_buf[1 << (shift)]; \
+    static t_box name = {name##_buf, 0, (shift), 0, 0}
+
+/* Retourne la moyenne des échantillons reçus (moins de 2^shift au début) */
+uint16_t filter_box_update(t_box *f, uint16_t x);
+
+/* ---- Moyenne exponentielle (EMA), coefficient 1/2^shift ----
+ * y += (x - y) / 2^shift, y gardé avec shift bits de fraction.
+ * Constante de temps ~2^shift échantillons. shift <= 15.
+ */
+typedef struct s_ema
+{
+    uint32_t acc;           // y * 2^shift
+    uint8_t  shift;
+    uint8_t  ready;         // 0 : le premier échantillon initialise y
+} t_ema;
+
+#define FILTER_EMA(name, shift) \
+    static t_ema name = {0, (shift), 0}
+
+uint16_t filter_ema_update(t_ema *f, uint16_t x);
+
+/* ---- Médiane glissante sur 3 ou 5 échantillons ----
+ * Supprime les pics isolés sans lisser les fronts
+ */
+#define FILTER_MEDIAN_MAX 5
+
+typedef struct s_median
+{
+    uint16_t buf[FILTER_MEDIAN_MAX];
+    uint8_t  len;           // 3 ou 5
+    uint8_t  pos;
+    uint8_t  ready;         // 0 : le premier échantillon remplit la fenêtre
+} t_median;
+
+#define FILTER_MEDIAN(name, len) \
+    static t_median name = {{0}, (len), 0, 0}
+
+uint16_t filter_median_update(t_median *f, uint16_t x);
+
+/* Médiane de 3 valeurs (3 comparaisons au plus) */
+uint16_t filter_median3(uint16_t a, uint16_t b, uint16_t c);
+
+/* ---- Hystérésis (trigger de Schmitt) sur plusieurs niveaux ----
+ * thr : seuils croissants. Le niveau monte quand x >= thr[level],
+ * redescend quand x < thr[level - 1] - band : une valeur qui hésite
+ * autour d'un seuil ne fait plus clignoter la sortie.
+ */
+typedef struct s_hyst
+{
+    const uint16_t *thr;
+    uint8_t         count;  // nombre de seuils, niveau 0..count
+    uint16_t        band;
+    uint8_t         level;
+} t_hyst;
+
+#define FILTER_HYST(name, thr, band) \
+    static t_hyst name = {(thr), sizeof(thr) / sizeof((thr)[0]), (band), 0}
+
+uint8_t  filter_hyst_update(t_hyst *f, uint16_t x);
+
+#endif
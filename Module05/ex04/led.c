@@ -85,28 +85,27 @@ void set_rgb(uint8_t r, uint8_t g, uint8_t b)
 }
 
 /* Affiche la jauge digitale sur les LEDs D1-D4
- * selon la valeur ADC (0-1023)
+ * level = nombre de LEDs allumées (0-4), calculé dans le main avec
+ * hystérésis sur les seuils 25/50/75/100% de l'ADC :
  * 
  * D1 : 25%  → ADC >= 256  (1023 * 0.25) → PB0
  * D2 : 50%  → ADC >= 512  (1023 * 0.50) → PB1
  * D3 : 75%  → ADC >= 768  (1023 * 0.75) → PB2
- * D4 : 100% → ADC >= 1023 (1023 * 1.00) → PB4
+ * D4 : 100% → ADC >= 1020 (avec marge)  → PB4
  */
-void led_set_var(uint16_t adc_value)
+void led_set_level(uint8_t level)
 {
-    // Éteindre toutes les LEDs d'abord
-    PORTB &= ~((1 << PB0) | (1 << PB1) | (1 << PB2) | (1 << PB4));
-    
-    // Allumer les LEDs selon le niveau
-    if (adc_value >= 256)   // >= 25%
-        PORTB |= (1 << PB0);
-    
-    if (adc_value >= 512)   // >= 50%
-        PORTB |= (1 << PB1);
-    
-    if (adc_value >= 768)   // >= 75%
-        PORTB |= (1 << PB2);
-    
-    if (adc_value >= 1020)  // >= 100% (avec marge)
-        PORTB |= (1 << PB4);
+    uint8_t leds = 0;
+
+    if (level >= 1)
+        leds |= (1 << PB0);
+    if (level >= 2)
+        leds |= (1 << PB1);
+    if (level >= 3)
+        leds |= (1 << PB2);
+    if (level >= 4)
+        leds |= (1 << PB4);
+
+    // Une seule écriture : pas d'extinction intermédiaire visible
+    PORTB = (PORTB & ~((1 << PB0) | (1 << PB1) | (1 << PB2) | (1 << PB4))) | leds;
 }
@@ -13,6 +13,17 @@
 #include "main.h"
 
 
+/* Seuils de la jauge (D1-D4) et bande d'hystérésis en LSB */
+static const uint16_t g_thresholds[] = {256, 512, 768, 1020};
+#define GAUGE_BAND      12
+
+/* Filtres du potentiomètre :
+ * médiane de 3 (pics isolés), puis EMA 1/4 (~40ms à 10ms par lecture)
+ */
+FILTER_MEDIAN(g_spike, 3);
+FILTER_EMA(g_smooth, 2);
+FILTER_HYST(g_gauge, g_thresholds, GAUGE_BAND);
+
 int main(void)
 {
     uint16_t adc_value;
@@ -24,11 +35,13 @@ int main(void)
     
     while (1)
     {
-        // Lecture du potentiomètre RV1 (ADC0)
+        // Lecture du potentiomètre RV1 (ADC0), filtrée
         adc_value = adc_read(0);
+        adc_value = filter_median_update(&g_spike, adc_value);
+        adc_value = filter_ema_update(&g_smooth, adc_value);
         
-        // 1. Mise à jour (LEDs D1-D4)
-        led_set_var(adc_value);
+        // 1. Mise à jour (LEDs D1-D4), sans clignotement aux seuils
+        led_set_level(filter_hyst_update(&g_gauge, adc_value));
         
         // 2. Conversion ADC (0-1023) vers position wheel (0-255)
         wheel_position = adc_value >> 2;  // Division par 4 : 1023/4 = 255
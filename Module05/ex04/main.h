@@ -3,9 +3,10 @@
 
 #include <avr/io.h>
 #include <util/delay.h>
+#include "filter.h"
 
 void led_init(void);
-void led_set_var(uint16_t adc_value);
+void led_set_level(uint8_t level);
 void wheel(uint8_t pos);
 void set_rgb(uint8_t r, uint8_t g, uint8_t b);
 void adc_init(void);
@@ -0,0 +1,37 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   adc.c                                              :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: cmetee-b <cmetee-b@student.42.fr>          +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2025/11/28 17:02:11 by cmetee-b          #+#    #+#             */
+/*   Updated: 2025/11/28 17:40:36 by cmetee-b         ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+#include "main.h"
+
+/* Même réglage que Module05 : référence AVCC, prescaler 128 (125kHz),
+ * conversion 10 bits en 13 cycles ADC = 104µs
+ */
+void adc_init(void)
+{
+    ADMUX = (1 << REFS0);
+    ADCSRA = (1 << ADEN) | (1 << ADPS2) | (1 << ADPS1) | (1 << ADPS0);
+
+    /* Première conversion après activation jetée (24.9.2) */
+    ADCSRA |= (1 << ADSC);
+    while (ADCSRA & (1 << ADSC))
+        ;
+}
+
+/* ADC0 : RV1, ADC1 : LDR, ADC2 : NTC (Table 24-4) */
+uint16_t adc_read(uint8_t channel)
+{
+    ADMUX = (ADMUX & 0xF0) | (channel & 0x0F);
+    ADCSRA |= (1 << ADSC);
+    while (ADCSRA & (1 << ADSC))
+        ;
+    return ADC;
+}
@@ -15,48 +15,254 @@
 // https://files.seeedstudio.com/wiki/Grove-AHT20_I2C_Industrial_Grade_Temperature_and_Humidity_Sensor/AHT20-datasheet-2020-4-16.pdf
 
 
-void aht20_init(void)
-{    
-    // START condition
-    i2c_start();
-    
-    // Envoyer adresse AHT20 en mode WRITE
-    i2c_write((AHT20_ADDR << 1) | I2C_WRITE);
-    
-    // Envoyer commande d'initialisation: 0xBE 0x08 0x00
-    i2c_write(AHT20_INIT_CMD);
-    i2c_write(0x08);
-    i2c_write(0x00);
-    
-    // STOP condition
-    i2c_stop();
-    
-    // Attendre 10ms (datasheet requirement)
-    _delay_ms(10);
+/* Machine à états de mesure, avancée par aht20_poll() depuis la boucle
+ * principale. Les transferts I2C passent par l'ISR TWI et les attentes
+ * sont comparées à timer_millis() : aucun appel ne bloque plus de
+ * quelques µs, le main garde la main pendant les 80ms de conversion.
+ *
+ *   START      attente des 40ms après mise sous tension
+ *   CHECK      lecture de l'octet d'état (bit CAL)
+ *   CALIBRATE  commande 0xBE 0x08 0x00 envoyée, attente 10ms
+ *   IDLE       attente de la prochaine période
+ *   TRIGGERED  commande 0xAC 0x33 0x00 envoyée, attente 80ms
+ *   BUSY_POLL  lecture des 7 octets : si le bit BUSY est encore à 1,
+ *              on relit AHT20_POLL_MS plus tard
+ *   puis conversion = copie dans le slot, retour à IDLE
+ */
+#define AHT20_BUSY_BIT  7
+#define AHT20_CAL_BIT   3
+
+/* CRC-8 de la trame (datasheet 5.4 step 5) : polynôme x^8 + x^5 + x^4 + 1
+ * (0x31), valeur initiale 0xFF, sur les octets 0 à 5 ; l'octet 6 est le
+ * CRC envoyé par le capteur. Table : CRC d'un octet seul, 1 lecture flash
+ * par octet au lieu de 8 décalages
+ */
+static const uint8_t g_crc8_table[256] PROGMEM =
+{
+    0x00, 0x31, 0x62, 0x53, 0xC4, 0xF5, 0xA6, 0x97,
+    0xB9, 0x88, 0xDB, 0xEA, 0x7D, 0x4C, 0x1F, 0x2E,
+    0x43, 0x72, 0x21, 0x10, 0x87, 0xB6, 0xE5, 0xD4,
+    0xFA, 0xCB, 0x98, 0xA9, 0x3E, 0x0F, 0x5C, 0x6D,
+    0x86, 0xB7, 0xE4, 0xD5, 0x42, 0x73, 0x20, 0x11,
+    0x3F, 0x0E, 0x5D, 0x6C, 0xFB, 0xCA, 0x99, 0xA8,
+    0xC5, 0xF4, 0xA7, 0x96, 0x01, 0x30, 0x63, 0x52,
+    0x7C, 0x4D, 0x1E, 0x2F, 0xB8, 0x89, 0xDA, 0xEB,
+    0x3D, 0x0C, 0x5F, 0x6E, 0xF9, 0xC8, 0x9B, 0xAA,
+    0x84, 0xB5, 0xE6, 0xD7, 0x40, 0x71, 0x22, 0x13,
+    0x7E, 0x4F, 0x1C, 0x2D, 0xBA, 0x8B, 0xD8, 0xE9,
+    0xC7, 0xF6, 0xA5, 0x94, 0x03, 0x32, 0x61, 0x50,
+    0xBB, 0x8A, 0xD9, 0xE8, 0x7F, 0x4E, 0x1D, 0x2C,
+    0x02, 0x33, 0x60, 0x51, 0xC6, 0xF7, 0xA4, 0x95,
+    0xF8, 0xC9, 0x9A, 0xAB, 0x3C, 0x0D, 0x5E, 0x6F,
+    0x41, 0x70, 0x23, 0x12, 0x85, 0xB4, 0xE7, 0xD6,
+    0x7A, 0x4B, 0x18, 0x29, 0xBE, 0x8F, 0xDC, 0xED,
+    0xC3, 0xF2, 0xA1, 0x90, 0x07, 0x36, 0x65, 0x54,
+    0x39, 0x08, 0x5B, 0x6A, 0xFD, 0xCC, 0x9F, 0xAE,
+    0x80, 0xB1, 0xE2, 0xD3, 0x44, 0x75, 0x26, 0x17,
+    0xFC, 0xCD, 0x9E, 0xAF, 0x38, 0x09, 0x5A, 0x6B,
+    0x45, 0x74, 0x27, 0x16, 0x81, 0xB0, 0xE3, 0xD2,
+    0xBF, 0x8E, 0xDD, 0xEC, 0x7B, 0x4A, 0x19, 0x28,
+    0x06, 0x37, 0x64, 0x55, 0xC2, 0xF3, 0xA0, 0x91,
+    0x47, 0x76, 0x25, 0x14, 0x83, 0xB2, 0xE1, 0xD0,
+    0xFE, 0xCF, 0x9C, 0xAD, 0x3A, 0x0B, 0x58, 0x69,
+    0x04, 0x35, 0x66, 0x57, 0xC0, 0xF1, 0xA2, 0x93,
+    0xBD, 0x8C, 0xDF, 0xEE, 0x79, 0x48, 0x1B, 0x2A,
+    0xC1, 0xF0, 0xA3, 0x92, 0x05, 0x34, 0x67, 0x56,
+    0x78, 0x49, 0x1A, 0x2B, 0xBC, 0x8D, 0xDE, 0xEF,
+    0x82, 0xB3, 0xE0, 0xD1, 0x46, 0x77, 0x24, 0x15,
+    0x3B, 0x0A, 0x59, 0x68, 0xFF, 0xCE, 0x9D, 0xAC,
+};
+
+static const uint8_t g_cmd_init[3] = {AHT20_INIT_CMD, 0x08, 0x00};
+static const uint8_t g_cmd_trigger[3] = {AHT20_TRIGGER_CMD, 0x33, 0x00};
+
+static uint8_t    g_state = AHT20_START;
+static uint16_t   g_period = AHT20_PERIOD_MS;
+static uint32_t   g_since;                  // début de l'attente en cours (ms)
+static uint32_t   g_trigger;                // dernier déclenchement (ms)
+static uint16_t   g_wait;                   // durée de l'attente en cours (ms)
+static uint8_t    g_rx[7];                  // trame en cours de réception
+static t_twi_xfer g_xfer;
+
+static char       g_last[7];                // dernière trame valide
+static uint16_t   g_seq = 0;
+static uint8_t    g_retries = 0;            // relectures de la trame en cours
+static t_aht20_stats g_stats = {0, 0, 0, 0};
+
+static uint8_t aht20_crc8(const uint8_t *data, uint8_t len)
+{
+    uint8_t crc = 0xFF;
+
+    while (len--)
+        crc = pgm_read_byte(&g_crc8_table[crc ^ *data++]);
+    return crc;
 }
 
-void aht20_trigger_measurement(void)
-{   
-    // START condition
-    i2c_start();
-    
-    // Adresse en mode WRITE
-    i2c_write((AHT20_ADDR << 1) | I2C_WRITE);
-    
-    // Commande trigger: 0xAC 0x33 0x00
-    i2c_write(AHT20_TRIGGER_CMD);
-    i2c_write(0x33);
-    i2c_write(0x00);
-    
-    // STOP condition
-    i2c_stop();
-    
-    // Attendre la mesure (80ms minimum selon datasheet)
-   _delay_ms(80);
+static void aht20_wait(uint32_t now, uint16_t ms)
+{
+    g_since = now;
+    g_wait = ms;
 }
 
-/*
- * Calcule l'humidité relative en % à partir des données brutes
+static uint8_t aht20_elapsed(uint32_t now)
+{
+    return (uint32_t)(now - g_since) >= g_wait;
+}
+
+/* Lance un transfert ; bus occupé : on retentera au prochain poll */
+static uint8_t aht20_submit(const uint8_t *wbuf, uint8_t wlen, uint8_t rlen)
+{
+    g_xfer.addr = AHT20_ADDR;
+    g_xfer.wbuf = wbuf;
+    g_xfer.wlen = wlen;
+    g_xfer.rbuf = g_rx;
+    g_xfer.rlen = rlen;
+    g_xfer.callback = 0;
+    return twi_submit(&g_xfer);
+}
+
+void aht20_init(uint16_t period_ms)
+{
+    g_period = period_ms;
+    g_state = AHT20_START;
+    aht20_wait(timer_millis(), AHT20_POWERUP_MS);
+}
+
+uint8_t aht20_poll(void)
+{
+    uint32_t now = timer_millis();
+
+    /* Transfert en cours : rien à faire pour l'instant (twi_poll le
+     * termine en TWI_ERR_TIMEOUT si le bus est bloqué)
+     */
+    twi_poll();
+    if (g_xfer.status == TWI_BUSY)
+        return AHT20_EVT_NONE;
+
+    switch (g_state)
+    {
+        case AHT20_START:
+            if (aht20_elapsed(now) && aht20_submit(0, 0, 1))
+                g_state = AHT20_CHECK;
+            break;
+
+        case AHT20_CHECK:
+            if (g_xfer.status != TWI_OK)
+                break;
+            if (g_rx[0] & (1 << AHT20_CAL_BIT))
+            {
+                g_state = AHT20_IDLE;
+                aht20_wait(now, 0);
+            }
+            else if (aht20_submit(g_cmd_init, 3, 0))
+            {
+                g_state = AHT20_CALIBRATE;
+                aht20_wait(now, AHT20_CALIBRATE_MS);
+            }
+            break;
+
+        case AHT20_CALIBRATE:
+            if (g_xfer.status != TWI_OK)
+                break;
+            if (aht20_elapsed(now))
+            {
+                g_state = AHT20_IDLE;
+                aht20_wait(now, 0);
+            }
+            break;
+
+        case AHT20_IDLE:
+            if (aht20_elapsed(now) && aht20_submit(g_cmd_trigger, 3, 0))
+            {
+                g_state = AHT20_TRIGGERED;
+                g_trigger = now;
+                g_retries = 0;
+                aht20_wait(now, AHT20_MEASURE_MS);
+            }
+            break;
+
+        case AHT20_TRIGGERED:
+            if (g_xfer.status != TWI_OK)
+                break;
+            if (aht20_elapsed(now) && aht20_submit(0, 0, 7))
+                g_state = AHT20_BUSY_POLL;
+            break;
+
+        case AHT20_BUSY_POLL:
+            if (g_xfer.status != TWI_OK)
+                break;
+            if (g_rx[0] & (1 << AHT20_BUSY_BIT))
+            {
+                /* Pas encore fini : nouvelle lecture un peu plus tard */
+                g_state = AHT20_TRIGGERED;
+                aht20_wait(now, AHT20_POLL_MS);
+                break;
+            }
+            if (aht20_crc8(g_rx, 6) != g_rx[6])
+            {
+                /* Trame abîmée sur le bus : le capteur garde la mesure,
+                 * on la relit ; au-delà de AHT20_CRC_RETRY, elle est jetée
+                 */
+                g_stats.crc_errors++;
+                if (g_retries < AHT20_CRC_RETRY && aht20_submit(0, 0, 7))
+                {
+                    g_retries++;
+                    break;
+                }
+                g_stats.dropped++;
+                g_state = AHT20_IDLE;
+                aht20_wait(g_trigger, g_period);
+                return AHT20_EVT_DROPPED;
+            }
+            for (uint8_t i = 0; i < 7; i++)
+                g_last[i] = g_rx[i];
+            g_seq++;
+            g_stats.frames++;
+            /* Période comptée depuis le déclenchement, pas depuis la fin */
+            g_state = AHT20_IDLE;
+            aht20_wait(g_trigger, g_period);
+            return AHT20_EVT_DATA;
+    }
+
+    /* Un transfert vient d'échouer : on repart de la vérification du
+     * capteur après une période complète
+     */
+    if (g_state != AHT20_START && g_state != AHT20_IDLE
+        && g_xfer.status != TWI_OK && g_xfer.status != TWI_BUSY)
+    {
+        g_stats.i2c_errors++;
+        g_state = AHT20_START;
+        aht20_wait(now, g_period);
+        return AHT20_EVT_ERROR;
+    }
+    return AHT20_EVT_NONE;
+}
+
+uint16_t aht20_get(char *data)
+{
+    for (uint8_t i = 0; i < 7; i++)
+        data[i] = g_last[i];
+    return g_seq;
+}
+
+uint8_t aht20_state(void)
+{
+    return g_state;
+}
+
+const t_aht20_stats *aht20_stats(void)
+{
+    return &g_stats;
+}
+
+/* Conversions entières (pas de float) : les facteurs de la datasheet
+ * se simplifient en x625 puis décalage, qui tient sur 32 bits
+ *   RH   = raw / 2^20 × 100         -> centièmes : raw × 625 / 2^16
+ *   T    = raw / 2^20 × 200 - 50    -> centièmes : raw × 625 / 2^15 - 5000
+ * Résultat arrondi au centième le plus proche (écart <= 0.005)
+ */
+
+/* Valeur brute 20 bits de l'humidité
  * 
  * Format des données AHT20 (7 octets):
  * [0]: Status byte
@@ -69,44 +275,28 @@ void aht20_trigger_measurement(void)
  * 
  * Référence: AHT20 Datasheet section "Data Format"
  */
-float calculate_humidity(char *data)
+static uint32_t aht20_raw20_humidity(const char *data)
+{
+    // Attention: cast en unsigned char pour éviter l'extension de signe
+    return ((uint32_t)(unsigned char)data[1] << 12) |  // Byte 1: bits 19-12
+           ((uint16_t)(unsigned char)data[2] << 4) |   // Byte 2: bits 11-4
+           ((unsigned char)data[3] >> 4);              // Byte 3: bits 7-4 → 3-0
+}
+
+static uint32_t aht20_raw20_temperature(const char *data)
 {
-    // Extraire les 20 bits d'humidité
-    // Attention: il faut cast en unsigned pour éviter les problèmes de signe
-    uint32_t raw_humidity = 0;
-    
-    raw_humidity = ((uint32_t)(unsigned char)data[1] << 12) |  // Byte 1: bits 19-12
-                   ((uint32_t)(unsigned char)data[2] << 4) |    // Byte 2: bits 11-4
-                   ((uint32_t)(unsigned char)data[3] >> 4);     // Byte 3: bits 7-4 → 3-0
-    
-    // Formule: RH = (raw / 2^20) * 100
-    float humidity = ((float)raw_humidity / 1048576.0) * 100.0;
-    
-    return humidity;
+    return (((uint32_t)(unsigned char)data[3] & 0x0F) << 16) |  // bits 19-16
+           ((uint16_t)(unsigned char)data[4] << 8) |            // bits 15-8
+           ((unsigned char)data[5]);                            // bits 7-0
 }
 
-/*
- * Calcule la température en °C à partir des données brutes
- * 
- * Format des données AHT20:
- * [3]: Humidité [3:0] (bits 7:4) | Température [19:16] (bits 3:0)
- * [4]: Température [15:8]
- * [5]: Température [7:0]
- * 
- * Référence: AHT20 Datasheet section "Data Format"
- */
-float calculate_temperature(char *data)
+uint16_t calculate_humidity(const char *data)
 {
-    // Extraire les 20 bits de température
-    // Attention: cast en unsigned char pour éviter l'extension de signe
-    uint32_t raw_temp = 0;
-    
-    raw_temp = (((uint32_t)(unsigned char)data[3] & 0x0F) << 16) |  // Byte 3: bits 3-0 → 19-16
-               ((uint32_t)(unsigned char)data[4] << 8) |             // Byte 4: bits 15-8
-               ((uint32_t)(unsigned char)data[5]);                   // Byte 5: bits 7-0
-    
-    // Formule: T = (raw / 2^20) * 200 - 50
-    float temperature = ((float)raw_temp / 1048576.0) * 200.0 - 50.0;
-    
-    return temperature;
+    return (aht20_raw20_humidity(data) * 625 + (1UL << 15)) >> 16;
+}
+
+int16_t calculate_temperature(const char *data)
+{
+    return (int16_t)((aht20_raw20_temperature(data) * 625 + (1UL << 14)) >> 15)
+           - 5000;
 }
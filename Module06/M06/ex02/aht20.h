@@ -14,26 +14,73 @@
 #define AHT20_H
 
 #include <stdint.h>
+#include <avr/pgmspace.h>
 
 #define AHT20_ADDR 0x38
 #define AHT20_INIT_CMD    0xBE  // 1011 1110 - Initialization
 #define AHT20_TRIGGER_CMD 0xAC  // 1010 1100 - Trigger Measurement
 
 
+/* Timings (datasheet 5.4), en ms */
+#define AHT20_POWERUP_MS    40      // après mise sous tension
+#define AHT20_CALIBRATE_MS  10      // après la commande 0xBE
+#define AHT20_MEASURE_MS    80      // après la commande 0xAC
+#define AHT20_POLL_MS       10      // relecture tant que BUSY = 1
+#ifndef AHT20_CRC_RETRY
+# define AHT20_CRC_RETRY    2       // relectures d'une trame au CRC faux
+#endif
+#ifndef AHT20_PERIOD_MS
+# define AHT20_PERIOD_MS    1000    // entre deux déclenchements
+#endif
+
+/* États de la mesure (aht20_state) */
+#define AHT20_START         0
+#define AHT20_CHECK         1
+#define AHT20_CALIBRATE     2
+#define AHT20_IDLE          3
+#define AHT20_TRIGGERED     4
+#define AHT20_BUSY_POLL     5
+
+/* Retour de aht20_poll */
+#define AHT20_EVT_NONE      0
+#define AHT20_EVT_DATA      1       // nouvelle trame dans le slot
+#define AHT20_EVT_ERROR     2       // transfert I2C raté, reprise au début
+#define AHT20_EVT_DROPPED   3       // CRC faux après toutes les relectures
+
+/* Compteurs depuis le démarrage */
+typedef struct s_aht20_stats
+{
+    uint16_t frames;        // trames valides
+    uint16_t i2c_errors;    // transferts ratés (NACK, bus)
+    uint16_t crc_errors;    // trames reçues avec un CRC faux
+    uint16_t dropped;       // mesures jetées (CRC faux à chaque relecture)
+} t_aht20_stats;
+
 /*
- * Initialise le capteur AHT20
+ * Démarre les mesures périodiques (non bloquant)
+ * timer_init(), i2c_init() et sei() doivent avoir été appelés
  */
-void aht20_init(void);
+void aht20_init(uint16_t period_ms);
 
 /*
- * Déclenche une mesure de température et d'humidité
+ * Fait avancer la mesure, à appeler souvent depuis la boucle principale
+ * (retour en quelques µs, jamais d'attente)
  */
-void aht20_trigger_measurement(void);
+uint8_t aht20_poll(void);
+
+/* Copie la dernière trame valide (7 octets, CRC vérifié), retourne son
+ * numéro
+ */
+uint16_t aht20_get(char *data);
+
+uint8_t aht20_state(void);
+
+const t_aht20_stats *aht20_stats(void);
 
-/* Calcul de l'humidité */
-float calculate_humidity(char *data);
+/* Humidité de la trame en centièmes de %RH (0..10000) */
+uint16_t calculate_humidity(const char *data);
 
-/* Calcul de la température */
-float calculate_temperature(char *data);
+/* Température de la trame en centièmes de °C (-5000..15000) */
+int16_t calculate_temperature(const char *data);
 
 #endif
\ No newline at end of file
@@ -0,0 +1,103 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   bus.c                                              :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: cmetee-b <cmetee-b@student.42.fr>          +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2025/11/28 10:14:52 by cmetee-b          #+#    #+#             */
+/*   Updated: 2025/11/28 16:03:29 by cmetee-b         ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+#include "main.h"
+#include "bus.h"
+
+static t_bus_dev *g_devs = 0;
+static uint8_t    g_count = 0;
+
+uint8_t bus_probe(uint8_t addr)
+{
+    t_twi_xfer x = {addr, 0, 0, 0, 0, 0, 0, 0, 0};
+
+    /* wlen = rlen = 0 : START, SLA+W, STOP */
+    if (!twi_submit(&x))
+        return 0;
+    return twi_wait(&x) == TWI_OK;
+}
+
+uint8_t bus_scan(uint8_t *found, uint8_t max)
+{
+    uint8_t n = 0;
+
+    for (uint8_t addr = BUS_ADDR_FIRST; addr <= BUS_ADDR_LAST; addr++)
+    {
+        if (!bus_probe(addr))
+            continue;
+        if (n < max)
+            found[n] = addr;
+        n++;
+    }
+    return n;
+}
+
+static void bus_check(t_bus_dev *dev, uint32_t now)
+{
+    dev->probed_ms = now;
+    if (!bus_probe(dev->addr))
+        return;
+    dev->present = 1;
+    dev->errors = 0;
+    if (dev->start)
+        dev->start(dev);
+}
+
+void bus_register(t_bus_dev *devs, uint8_t count)
+{
+    uint32_t now = timer_millis();
+
+    g_devs = devs;
+    g_count = count;
+    for (uint8_t i = 0; i < count; i++)
+    {
+        devs[i].present = 0;
+        bus_check(&devs[i], now);
+    }
+}
+
+void bus_poll(void)
+{
+    uint32_t now = timer_millis();
+
+    for (uint8_t i = 0; i < g_count; i++)
+    {
+        t_bus_dev *dev = &g_devs[i];
+
+        if (dev->present)
+        {
+            if (dev->poll)
+                dev->poll(dev);
+        }
+        /* Absent : un seul sondage de temps en temps, pas de tentative
+         * (et de timeout) à chaque tour ; bus occupé, on attend le tour
+         * suivant
+         */
+        else if ((uint32_t)(now - dev->probed_ms) >= BUS_RESCAN_MS
+                 && !twi_busy())
+            bus_check(dev, now);
+    }
+}
+
+void bus_report(t_bus_dev *dev, uint8_t ok)
+{
+    if (ok)
+    {
+        dev->errors = 0;
+        return;
+    }
+    if (++dev->errors >= BUS_MAX_ERRORS)
+    {
+        dev->present = 0;
+        dev->probed_ms = timer_millis();
+    }
+}
@@ -0,0 +1,72 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   bus.h                                              :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: cmetee-b <cmetee-b@student.42.fr>          +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2025/11/28 10:14:52 by cmetee-b          #+#    #+#             */
+/*   Updated: 2025/11/28 16:03:29 by cmetee-b         ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+#ifndef BUS_H
+#define BUS_H
+
+#include <stdint.h>
+
+/* Scan du bus I2C et registre des périphériques connus
+ * Présence sondée par SLA+W (twi, transaction vide) : ACK = présent.
+ * Un périphérique absent n'est plus appelé à chaque tour de boucle, il est
+ * juste re-sondé toutes les BUS_RESCAN_MS ; un présent qui enchaîne
+ * BUS_MAX_ERRORS erreurs est marqué absent.
+ */
+#define BUS_ADDR_FIRST  0x08    // 0x00-0x07 et 0x78-0x7F réservés
+#define BUS_ADDR_LAST   0x77
+#ifndef BUS_RESCAN_MS
+# define BUS_RESCAN_MS  5000
+#endif
+#ifndef BUS_MAX_ERRORS
+# define BUS_MAX_ERRORS 3
+#endif
+
+typedef struct s_bus_dev t_bus_dev;
+
+/* Pilote d'un périphérique : start quand il apparaît (démarrage ou
+ * retour après absence), poll à chaque bus_poll tant qu'il est présent
+ */
+struct s_bus_dev
+{
+    const char *name;
+    uint8_t     addr;
+    void      (*start)(t_bus_dev *dev);
+    void      (*poll)(t_bus_dev *dev);
+    uint8_t     present;
+    uint8_t     errors;         // erreurs consécutives
+    uint32_t    probed_ms;      // dernier sondage
+};
+
+/* 1 si un esclave répond (ACK) à addr, 0 sinon ou bus occupé
+ * ~100µs à 100kHz, timeout par phase de twi.c
+ */
+uint8_t bus_probe(uint8_t addr);
+
+/* Sonde 0x08-0x77, range les adresses qui répondent dans found (max
+ * au plus), retourne le nombre trouvé (peut dépasser max). ~12ms à 100kHz
+ */
+uint8_t bus_scan(uint8_t *found, uint8_t max);
+
+/* Enregistre les périphériques, sonde chacun et appelle start de ceux
+ * qui sont présents
+ */
+void    bus_register(t_bus_dev *devs, uint8_t count);
+
+/* À appeler dans la boucle : poll des présents, re-sondage des absents */
+void    bus_poll(void);
+
+/* Résultat d'un échange du pilote avec le périphérique (ok = 0 : erreur
+ * I2C, BUS_MAX_ERRORS de suite le font passer absent)
+ */
+void    bus_report(t_bus_dev *dev, uint8_t ok);
+
+#endif
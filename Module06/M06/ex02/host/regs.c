@@ -0,0 +1,23 @@
+/* Registres et horloge simulés pour les tests PC (host/shim) */
+
+#include <avr/io.h>
+#include <stdint.h>
+
+volatile uint8_t TWBR, TWSR, TWCR, TWDR, TWAR;
+volatile uint8_t DDRB, PORTB, DDRC, PORTC;
+/* SDA et SCL relâchés : bus libre pour twi_recover */
+volatile uint8_t PINC = (1 << PC4) | (1 << PC5);
+volatile uint8_t SREG = (1 << SREG_I);
+
+/* Temps avancé à la main par les tests */
+uint32_t g_host_us = 0;
+
+uint32_t timer_micros(void)
+{
+    return g_host_us;
+}
+
+uint32_t timer_millis(void)
+{
+    return g_host_us / 1000;
+}
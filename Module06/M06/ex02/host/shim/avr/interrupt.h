@@ -0,0 +1,18 @@
+/* ISR(v) devient une fonction ordinaire appelée par le test,
+ * cli/sei ne font que changer le bit I de la variable SREG
+ */
+#ifndef SHIM_AVR_INTERRUPT_H
+#define SHIM_AVR_INTERRUPT_H
+
+#include <avr/io.h>
+
+#define ISR(vector)         void vector(void)
+#define TWI_vect            twi_vect
+#define TIMER0_COMPA_vect   timer0_compa_vect
+
+#define cli()               (SREG &= ~(1 << SREG_I))
+#define sei()               (SREG |= (1 << SREG_I))
+
+void twi_vect(void);
+
+#endif
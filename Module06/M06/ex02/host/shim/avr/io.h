@@ -0,0 +1,28 @@
+/* Registres de l'ATmega328P remplacés par des variables (host/regs.c) :
+ * seulement ceux dont twi.c et aht20.c ont besoin pour les tests PC
+ */
+#ifndef SHIM_AVR_IO_H
+#define SHIM_AVR_IO_H
+
+#include <stdint.h>
+
+extern volatile uint8_t TWBR, TWSR, TWCR, TWDR, TWAR;
+extern volatile uint8_t DDRB, PORTB, DDRC, PORTC, PINC;
+extern volatile uint8_t SREG;
+
+/* Bits de TWCR (21.9.2) */
+#define TWIE    0
+#define TWEN    2
+#define TWWC    3
+#define TWSTO   4
+#define TWSTA   5
+#define TWEA    6
+#define TWINT   7
+
+#define SREG_I  7
+
+#define PB0     0
+#define PC4     4
+#define PC5     5
+
+#endif
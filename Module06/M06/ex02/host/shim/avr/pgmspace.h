@@ -0,0 +1,11 @@
+/* Flash et RAM confondues sur PC */
+#ifndef SHIM_AVR_PGMSPACE_H
+#define SHIM_AVR_PGMSPACE_H
+
+#include <stdint.h>
+
+#define PROGMEM
+#define pgm_read_byte(addr) (*(const uint8_t *)(addr))
+#define pgm_read_word(addr) (*(const uint16_t *)(addr))
+
+#endif
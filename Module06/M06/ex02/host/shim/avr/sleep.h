@@ -0,0 +1,12 @@
+/* Pas de veille sur PC : le test appelle l'ISR lui-même */
+#ifndef SHIM_AVR_SLEEP_H
+#define SHIM_AVR_SLEEP_H
+
+#define SLEEP_MODE_IDLE     0
+#define set_sleep_mode(m)   ((void)(m))
+#define sleep_enable()
+#define sleep_disable()
+#define sleep_cpu()
+#define sleep_mode()
+
+#endif
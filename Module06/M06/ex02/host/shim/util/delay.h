@@ -0,0 +1,7 @@
+#ifndef SHIM_UTIL_DELAY_H
+#define SHIM_UTIL_DELAY_H
+
+#define _delay_ms(ms)   ((void)(ms))
+#define _delay_us(us)   ((void)(us))
+
+#endif
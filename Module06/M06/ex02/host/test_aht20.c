@@ -0,0 +1,82 @@
+/* Test PC exhaustif des conversions entières d'aht20.c : les 2^20 codes
+ * bruts, comparés à la formule de la datasheet en double.
+ * Arrondi au centième : écart max attendu 0.5 centième (0.005).
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include "../main.h"
+
+#define NB_CODES    (1UL << 20)
+#define MAX_ERR     0.5         // centièmes
+
+/* Trame AHT20 avec le même code brut pour l'humidité et la température */
+static void make_frame(char *frame, uint32_t raw)
+{
+    frame[0] = 0x1C;
+    frame[1] = raw >> 12;
+    frame[2] = raw >> 4;
+    frame[3] = ((raw & 0x0F) << 4) | ((raw >> 16) & 0x0F);
+    frame[4] = raw >> 8;
+    frame[5] = raw;
+    frame[6] = 0;
+}
+
+/* Datasheet : RH = raw / 2^20 × 100, T = raw / 2^20 × 200 - 50 */
+static double exact_hum(uint32_t raw)
+{
+    return raw / (double)NB_CODES * 100.0 * 100.0;
+}
+
+static double exact_temp(uint32_t raw)
+{
+    return (raw / (double)NB_CODES * 200.0 - 50.0) * 100.0;
+}
+
+/* Écart max en centièmes, et code où il est atteint */
+typedef struct s_err
+{
+    double   max;
+    uint32_t at;
+} t_err;
+
+static void track(t_err *e, double got, double exact, uint32_t raw)
+{
+    double err = fabs(got - exact);
+
+    if (err > e->max)
+    {
+        e->max = err;
+        e->at = raw;
+    }
+}
+
+static int report(const char *name, const t_err *e)
+{
+    printf("aht20 : %-22s ecart max %.4f centieme (code 0x%05lX)\n",
+           name, e->max, (unsigned long)e->at);
+    return e->max > MAX_ERR + 1e-9;
+}
+
+int main(void)
+{
+    char     frame[7];
+    t_err    hum = {0, 0};
+    t_err    temp = {0, 0};
+    int      fail = 0;
+
+    for (uint32_t raw = 0; raw < NB_CODES; raw++)
+    {
+        make_frame(frame, raw);
+        track(&hum, calculate_humidity(frame), exact_hum(raw), raw);
+        track(&temp, calculate_temperature(frame), exact_temp(raw), raw);
+    }
+    fail |= report("calculate_humidity", &hum);
+    fail |= report("calculate_temperature", &temp);
+    if (fail)
+    {
+        printf("aht20 : ECHEC\n");
+        return 1;
+    }
+    return 0;
+}
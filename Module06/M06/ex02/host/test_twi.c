@@ -0,0 +1,228 @@
+/* Test PC du mode esclave de twi.c : le test joue le matériel TWI et le
+ * maître extérieur. Chaque étape du bus = un code TWSR (Tables 21-3 à
+ * 21-6) suivi d'un appel de l'ISR, puis on regarde ce qu'elle a écrit
+ * dans TWCR/TWDR.
+ */
+
+#include <stdio.h>
+#include "../main.h"
+
+#define ADDR        0x42
+#define MAP_SIZE    8
+
+#define TWCR_ACKED(v)   ((v) & (1 << TWEA))
+
+static int g_fail = 0;
+
+#define CHECK(cond) \
+    do { \
+        if (!(cond)) \
+        { \
+            printf("ECHEC %s:%d : %s\n", __FILE__, __LINE__, #cond); \
+            g_fail++; \
+        } \
+    } while (0)
+
+static uint8_t g_cb_calls = 0;
+
+static void on_done(t_twi_xfer *xfer)
+{
+    (void)xfer;
+    g_cb_calls++;
+}
+
+/* Une étape du bus : TWINT levé avec status, ISR appelée. Retourne le
+ * TWCR écrit par l'ISR ; comme le matériel, TWINT (écrit à 1) et TWSTO
+ * (STOP sorti) sont ensuite remis à 0
+ */
+static uint8_t bus(uint8_t status)
+{
+    uint8_t twcr;
+
+    TWSR = status;
+    TWCR |= (1 << TWINT);
+    twi_vect();
+    twcr = TWCR;
+    TWCR &= ~((1 << TWINT) | (1 << TWSTO) | (1 << TWSTA));
+    return twcr;
+}
+
+/* Maître extérieur : écriture du n° de registre puis STOP */
+static void master_set_ptr(uint8_t reg)
+{
+    CHECK(TWCR_ACKED(bus(TW_SR_SLA_ACK)));
+    TWDR = reg;
+    CHECK(TWCR_ACKED(bus(TW_SR_DATA_ACK)));
+    bus(TW_SR_STOP);
+}
+
+/* Maître extérieur : lecture de n octets (NACK sur le dernier) */
+static void master_read(uint8_t *buf, uint8_t n)
+{
+    bus(TW_ST_SLA_ACK);
+    for (uint8_t i = 0; i < n; i++)
+    {
+        buf[i] = TWDR;
+        if (i + 1 < n)
+            bus(TW_ST_DATA_ACK);
+    }
+    bus(TW_ST_DATA_NACK);
+}
+
+static void test_pointer_and_increment(void)
+{
+    uint8_t buf[4];
+
+    master_set_ptr(2);
+    master_read(buf, 4);
+    CHECK(buf[0] == 0xAB && buf[1] == 0xCD);
+    CHECK(buf[2] == 0x55 && buf[3] == 0x66);
+
+    /* Le pointeur reste après la lecture : on continue à 6 */
+    master_read(buf, 2);
+    CHECK(buf[0] == 0x77 && buf[1] == 0x88);
+
+    /* Écriture du registre + repeated START + lecture */
+    CHECK(TWCR_ACKED(bus(TW_SR_SLA_ACK)));
+    TWDR = 0;
+    bus(TW_SR_DATA_ACK);
+    master_read(buf, 2);
+    CHECK(buf[0] == 0x12 && buf[1] == 0x34);
+}
+
+static void test_snapshot(void)
+{
+    uint8_t hi;
+    uint8_t lo;
+
+    master_set_ptr(2);
+    bus(TW_ST_SLA_ACK);
+    hi = TWDR;
+    /* Le main change la valeur entre les deux octets d'une lecture */
+    twi_slave_set(2, 0x0102);
+    bus(TW_ST_DATA_ACK);
+    lo = TWDR;
+    bus(TW_ST_DATA_NACK);
+    CHECK(hi == 0xAB && lo == 0xCD);
+
+    /* La lecture suivante voit la nouvelle valeur entière */
+    uint8_t buf[2];
+
+    master_set_ptr(2);
+    master_read(buf, 2);
+    CHECK(buf[0] == 0x01 && buf[1] == 0x02);
+    twi_slave_set(2, 0xABCD);
+}
+
+static void test_past_end(void)
+{
+    uint8_t buf[4];
+
+    master_set_ptr(MAP_SIZE - 2);
+    master_read(buf, 4);
+    CHECK(buf[0] == 0x77 && buf[1] == 0x88);
+    CHECK(buf[2] == 0xFF && buf[3] == 0xFF);
+
+    master_set_ptr(0x30);
+    master_read(buf, 1);
+    CHECK(buf[0] == 0xFF);
+}
+
+static void test_master_aborted(void)
+{
+    static const uint8_t cmd[3] = {0xAC, 0x33, 0x00};
+    t_twi_xfer           x = {0x38, cmd, 3, 0, 0, on_done, 0, 0, 0};
+    uint8_t              twcr;
+    uint8_t              buf[2];
+
+    /* Esclave adressé : twi_submit refuse tant que l'échange n'est pas fini */
+    bus(TW_SR_SLA_ACK);
+    CHECK(!twi_submit(&x));
+    bus(TW_SR_STOP);
+
+    CHECK(twi_submit(&x));
+    CHECK(x.status == TWI_BUSY);
+    CHECK(TWCR & (1 << TWSTA));
+    CHECK(TWCR_ACKED(TWCR));
+    TWCR &= ~((1 << TWINT) | (1 << TWSTA));
+    /* Interruptions rétablies par twi_submit */
+    CHECK(SREG & (1 << SREG_I));
+
+    /* START sorti, puis arbitrage perdu pendant SLA+W : l'autre maître
+     * nous adresse en lecture
+     */
+    bus(TW_START);
+    CHECK(TWDR == ((0x38 << 1) | TW_WRITE));
+    twcr = bus(TW_ST_ARB_LOST_SLA_ACK);
+    CHECK(x.status == TWI_ERR_ARB_LOST);
+    CHECK(x.twsr == TW_ST_ARB_LOST_SLA_ACK);
+    CHECK(g_cb_calls == 1);
+    CHECK(!twi_busy());
+    CHECK(TWCR_ACKED(twcr));
+    /* On répond quand même au maître, à partir du registre courant
+     * (0x31 après test_past_end : hors de la carte)
+     */
+    buf[0] = TWDR;
+    bus(TW_ST_DATA_NACK);
+    CHECK(buf[0] == 0xFF);
+
+    /* Le bus est libre : la transaction se relance et va au bout */
+    CHECK(twi_submit(&x));
+    TWCR &= ~((1 << TWINT) | (1 << TWSTA));
+    bus(TW_START);
+    bus(TW_MT_SLA_ACK);
+    CHECK(TWDR == 0xAC);
+    bus(TW_MT_DATA_ACK);
+    bus(TW_MT_DATA_ACK);
+    twcr = bus(TW_MT_DATA_ACK);
+    CHECK(twcr & (1 << TWSTO));
+    CHECK(x.status == TWI_OK);
+    CHECK(g_cb_calls == 2);
+}
+
+/* Étape maître arrivée après la fin de la transaction : STOP, sauf
+ * arbitrage perdu (le bus est à l'autre maître)
+ */
+static void test_stray_master_status(void)
+{
+    uint8_t twcr;
+
+    CHECK(!twi_busy());
+    twcr = bus(TW_START);
+    CHECK(twcr & (1 << TWSTO));
+    CHECK(TWCR_ACKED(twcr));
+    twcr = bus(TW_MT_ARB_LOST);
+    CHECK(!(twcr & (1 << TWSTO)));
+    CHECK(TWCR_ACKED(twcr));
+}
+
+int main(void)
+{
+    uint16_t reads;
+
+    TWCR = (1 << TWEN);
+    twi_slave_init(ADDR, MAP_SIZE);
+    CHECK(TWAR == ADDR << 1);
+    CHECK(TWCR_ACKED(TWCR) && (TWCR & (1 << TWIE)));
+    twi_slave_set(0, 0x1234);
+    twi_slave_set(2, 0xABCD);
+    twi_slave_set(4, 0x5566);
+    twi_slave_set(6, 0x7788);
+
+    test_pointer_and_increment();
+    test_snapshot();
+    test_past_end();
+    reads = twi_slave_reads();
+    CHECK(reads == 7);
+    test_master_aborted();
+    test_stray_master_status();
+    CHECK(twi_slave_reads() == reads + 1);
+
+    if (g_fail)
+    {
+        printf("twi : %d echec(s)\n", g_fail);
+        return 1;
+    }
+    printf("twi : esclave et abandon maitre OK\n");
+    return 0;
+}
@@ -26,13 +26,12 @@ void   i2c_init(void)
     PORTC &= ~(1 << PC4);
     PORTC &= ~(1 << PC5);
     
-    // Configuration du bit rate pour 100kHz
-    TWBR = 72;
-    
-    /* TWSR: Prescaler bits (TWPS1:0) = 00 → Prescaler = 1
+    /* Bit rate : TWI_FREQ (100kHz par défaut, 400kHz avec
+     * -DTWI_FREQ=400000), TWBR et prescaler calculés à la compilation
+     * 100kHz à 16MHz : TWBR = 72, TWPS = 0 (prescaler 1)
      * section 21.9.3 "TWSR – TWI Status Register" p.200
      */
-    TWSR = 0x00;
+    twi_set_bitrate(TWI_DEFAULT);
 
     /* Activatio du module TWI 
      * section 21.9.2 TWCR – TWI Control Register p.199
@@ -40,8 +39,32 @@ void   i2c_init(void)
      */
 
      TWCR = (1 << TWEN);
+
+    /* Statistiques d'erreurs gardées depuis le dernier reset à chaud,
+     * et bus débloqué si un esclave tient encore SDA (reset pendant
+     * une lecture)
+     */
+    twi_stats_init();
+    if (!(PINC & (1 << PC4)))
+        twi_recover();
+}
+
+/* TWI_OK si TWSR vaut l'un des deux états attendus, sinon l'erreur
+ * correspondante (comptée dans les statistiques)
+ */
+static uint8_t i2c_check(uint8_t expected, uint8_t other)
+{
+    uint8_t status = i2c_get_status();
+    uint8_t err;
+
+    if (status == expected || status == other)
+        return TWI_OK;
+    err = twi_error(status);
+    twi_record(err);
+    return err;
 }
 
+
 /*
  * On Génère une condition START sur le bus I2C
  * 
@@ -57,7 +80,7 @@ void   i2c_init(void)
  * - Figure 21-10 - p.181 "Interfacing the Application to the TWI in a Typical Transmission"
  * - Table 21-2. Assembly code Example p.183 - ligne 1
  */
-void    i2c_start(void)
+uint8_t i2c_start(void)
 {
     /* On génère la condition START */
     TWCR = (1 << TWINT) | (1 << TWSTA) | (1 << TWEN);
@@ -65,20 +88,36 @@ void    i2c_start(void)
     /* Attendre que TWINT soit mis à 1 (opération terminée)
      * TWINT est clear automatiquement quand l'opération commence
      * et set automatiquement quand elle se termine
+     * Au plus TWI_PHASE_TIMEOUT_US : bus bloqué -> TWI_ERR_TIMEOUT
      */
-    while (!(TWCR & (1 << TWINT)))
-        ;
+    if (twi_wait_twint() != TWI_OK)
+        return TWI_ERR_TIMEOUT;
+    return i2c_check(TW_START, TW_REP_START);
 }
 
 
-void    i2c_stop(void)
+uint8_t i2c_stop(void)
 {
+    uint32_t start = timer_micros();
+
         /* On génère la condition STOP */
     TWCR = (1 << TWINT) | (1 << TWSTO) | (1 << TWEN);
+
+    /* TWSTO repasse à 0 une fois le STOP sorti sur le bus */
+    while (TWCR & (1 << TWSTO))
+    {
+        if (timer_micros() - start >= TWI_PHASE_TIMEOUT_US)
+        {
+            twi_record(TWI_ERR_TIMEOUT);
+            twi_recover();
+            return TWI_ERR_TIMEOUT;
+        }
+    }
+    return TWI_OK;
 }
 
 
-void    i2c_write(unsigned char data)
+uint8_t i2c_write(unsigned char data)
 {
     /* on charge la data dans le registre */
     TWDR = data;
@@ -87,12 +126,16 @@ void    i2c_write(unsigned char data)
     TWCR = (1 << TWINT) | (1 << TWEN);
     
     /* Attendre la fin */
-    while (!(TWCR & (1 << TWINT)))
-        ;
+    if (twi_wait_twint() != TWI_OK)
+        return TWI_ERR_TIMEOUT;
+    /* Adresse (SLA+W/R) ou donnée : ACK attendu */
+    if (i2c_get_status() == TW_MR_SLA_ACK)
+        return TWI_OK;
+    return i2c_check(TW_MT_SLA_ACK, TW_MT_DATA_ACK);
 }
 
 
-void   i2c_read(void)
+uint8_t i2c_read(void)
 {
     /* Activer la réception avec ACK 
      * TWEA (bit 6): TWI Enable Acknowledge
@@ -100,24 +143,26 @@ void   i2c_read(void)
     TWCR = (1 << TWINT) | (1 << TWEN) | (1 << TWEA);
     
     /* Attendre la réception */
-    while (!(TWCR & (1 << TWINT)))
-        ;
+    if (twi_wait_twint() != TWI_OK)
+        return TWI_ERR_TIMEOUT;
     
     // Le résultat est maintenant dans TWDR
     // (L'affichage sera fait par print_hex dans le main)
+    return i2c_check(TW_MR_DATA_ACK, TW_MR_DATA_ACK);
 }
 
 
-void    i2c_read_last(void)
+uint8_t i2c_read_last(void)
 {
     /* Activer la réception SANS ACK (pas de TWEA) */
     TWCR = (1 << TWINT) | (1 << TWEN);
     
     /* Attendre la réception */
-    while (!(TWCR & (1 << TWINT)))
-        ;
+    if (twi_wait_twint() != TWI_OK)
+        return TWI_ERR_TIMEOUT;
     
     // Le résultat est dans TWDR
+    return i2c_check(TW_MR_DATA_NACK, TW_MR_DATA_NACK);
 }
 
 
@@ -12,96 +12,416 @@
 
 #include "main.h"
 
+#ifndef TWI_BENCH
+# define TWI_BENCH 0
+#endif
+
+#if TWI_BENCH
+
+/* Banc de débit I2C (make TWI_BENCH=1) : BENCH_COUNT transactions de
+ * chaque type à 100kHz puis à 400kHz, durée mesurée par twi.c de
+ * twi_submit au STOP (résolution 4µs). Transactions lancées une par une,
+ * sans rien d'autre sur le bus.
+ *   lecture : SLA+R + 7 octets (trame AHT20)
+ *   écriture : SLA+W + 3 octets (commande de mesure)
+ */
+# define BENCH_COUNT 32
+
+typedef struct s_bench
+{
+    uint16_t min;
+    uint16_t max;
+    uint32_t sum;
+    uint16_t errors;
+} t_bench;
+
+static void bench_run(const uint8_t *wbuf, uint8_t wlen, uint8_t *rbuf,
+                      uint8_t rlen, t_bench *res)
+{
+    t_twi_xfer x = {AHT20_ADDR, wbuf, wlen, rbuf, rlen, 0, 0, 0, 0};
+
+    res->min = 0xFFFF;
+    res->max = 0;
+    res->sum = 0;
+    res->errors = 0;
+    for (uint8_t i = 0; i < BENCH_COUNT; i++)
+    {
+        twi_submit(&x);
+        if (twi_wait(&x) != TWI_OK)
+        {
+            res->errors++;
+            continue;
+        }
+        res->sum += x.us;
+        if (x.us < res->min)
+            res->min = x.us;
+        if (x.us > res->max)
+            res->max = x.us;
+        // Laisser le capteur finir la mesure lancée par l'écriture
+        if (wlen)
+            _delay_ms(AHT20_MEASURE_MS);
+    }
+}
+
+static void bench_print(const char *name, const t_bench *res)
+{
+    uint8_t ok = BENCH_COUNT - res->errors;
+
+    uart_printstr(name);
+    if (!ok)
+    {
+        uart_println(" : pas de reponse");
+        return;
+    }
+    uart_printstr(" moy ");
+    uart_printfixed((res->sum + ok / 2) / ok, 0);
+    uart_printstr(" min ");
+    uart_printfixed(res->min, 0);
+    uart_printstr(" max ");
+    uart_printfixed(res->max, 0);
+    uart_printstr(" us, erreurs ");
+    uart_printfixed(res->errors, 0);
+    uart_println("");
+}
+
 int main(void)
 {
-    uint8_t sensor_initialized = 0;
+    static const uint8_t  trigger[3] = {AHT20_TRIGGER_CMD, 0x33, 0x00};
+    static const uint16_t speeds[2] = {TWI_100K, TWI_400K};
+    uint8_t               frame[7];
+    t_bench               res;
 
-    // Buffer pour stocker les 3 dernières mesures
-    float temp_history[3] = {0, 0, 0};
-    float hum_history[3] = {0, 0, 0};
-    uint8_t measure_count = 0;
-    
     uart_init();
     i2c_init();
-    
-    // Attendre 40ms après power-on
-    _delay_ms(40);
-    
+    timer_init();
+    sei();
+    _delay_ms(AHT20_POWERUP_MS);
+
     while (1)
     {
-        // Vérifier si le capteur est initialisé
-        if (!sensor_initialized)
+        for (uint8_t s = 0; s < 2; s++)
         {
-            i2c_start();
-            i2c_write((AHT20_ADDR << 1) | I2C_READ);
-            i2c_read();
-            uint8_t status = TWDR;
-            i2c_stop();
-
-             // Bit 3 = CAL (calibrated)
-            if (!(status & (1 << 3)))
-                aht20_init();
-            else
-                sensor_initialized = 1;
+            twi_set_bitrate(speeds[s]);
+            uart_printfixed(twi_bitrate_hz() / 1000, 0);
+            uart_println(" kHz");
+            bench_run(0, 0, frame, 7, &res);
+            bench_print("  lecture 7 octets ", &res);
+            bench_run(trigger, 3, 0, 0, &res);
+            bench_print("  ecriture 3 octets", &res);
+            uart_flush();
         }
-        
-        char data[7];
-
-        aht20_trigger_measurement();
-        
-        // Lecture des 7 octets
-        // Référence: AHT20 Datasheet section 5.4 step 4
-        i2c_start();
-        i2c_write((AHT20_ADDR << 1) | I2C_READ);
-        
-        // Lire les 6 premiers octets avec ACK
-        for (uint8_t i = 0; i < 6; i++)
+        _delay_ms(2000);
+    }
+    return 0;
+}
+
+#else
+
+/* Statistiques glissantes de chaque grandeur (stats.c) : l'affichage
+ * périodique utilise la moyenne, le terminal série tout le reste
+ */
+STATS(g_temp, STATS_AHT20_SIZE);
+STATS(g_hum, STATS_AHT20_SIZE);
+STATS(g_adc0, STATS_ADC_SIZE);
+STATS(g_adc1, STATS_ADC_SIZE);
+STATS(g_adc2, STATS_ADC_SIZE);
+
+typedef struct s_stream
+{
+    const char *name;
+    t_stats    *stats;
+    uint8_t     decimals;       // AHT20 : centièmes
+} t_stream;
+
+static const t_stream g_streams[] =
+{
+    {"temp", &g_temp, 2},
+    {"hum ", &g_hum, 2},
+    {"adc0", &g_adc0, 0},
+    {"adc1", &g_adc1, 0},
+    {"adc2", &g_adc2, 0},
+};
+
+# define NB_STREAMS (sizeof(g_streams) / sizeof(g_streams[0]))
+
+/* Pilote AHT20 pour le registre du bus : démarré quand le capteur
+ * répond, plus appelé quand il a disparu (re-sondé toutes les 5s)
+ */
+static void aht20_start(t_bus_dev *dev)
+{
+    (void)dev;
+    // Mesure toutes les secondes (machine à états dans aht20.c)
+    aht20_init(AHT20_PERIOD_MS);
+}
+
+static void aht20_print_errors(uint8_t event)
+{
+    const t_aht20_stats *stats = aht20_stats();
+
+    uart_printstr(event == AHT20_EVT_ERROR
+                  ? "AHT20: erreur I2C" : "AHT20: CRC faux, mesure jetee");
+    uart_printstr(" (i2c ");
+    uart_printfixed(stats->i2c_errors, 0);
+    uart_printstr(", crc ");
+    uart_printfixed(stats->crc_errors, 0);
+    uart_printstr(", jetees ");
+    uart_printfixed(stats->dropped, 0);
+    uart_printstr(", timeouts ");
+    uart_printfixed(twi_stats()->count[TWI_ERR_TIMEOUT], 0);
+    uart_printstr(", deblocages ");
+    uart_printfixed(twi_stats()->recoveries, 0);
+    uart_println(")");
+}
+
+static void aht20_print_data(void)
+{
+    char data[7];
+
+    aht20_get(data);
+
+    // Centièmes (entiers), puis moyenne sur la fenêtre
+    // (STATS_AHT20_WINDOW dernières mesures par défaut)
+    stats_update(&g_temp, calculate_temperature(data));
+    stats_update(&g_hum, (int16_t)calculate_humidity(data));
+    int16_t temp_avg = stats_mean(&g_temp);
+    int16_t hum_avg = stats_mean(&g_hum);
+    
+    // Afficher le résultat, arrondi au dixième
+    // Format: "Temperature: XX.X°C, Humidity: XX.X%"
+    uart_printstr("Temperature: ");
+    uart_printfixed((temp_avg + (temp_avg < 0 ? -5 : 5)) / 10, 1);
+    uart_printstr("C, Humidity: ");
+    uart_printfixed((hum_avg + 5) / 10, 1);
+    uart_println("%");
+
+    // Mêmes valeurs pour un maître I2C extérieur
+    twi_slave_set(REG_TEMP, temp_avg);
+    twi_slave_set(REG_HUM, hum_avg);
+}
+
+/* Carte de registres esclave : ADC toutes les ADC_PERIOD_MS, compteurs */
+static void slave_update(void)
+{
+    const t_aht20_stats *stats = aht20_stats();
+
+    for (uint8_t ch = 0; ch < 3; ch++)
+    {
+        uint16_t value = adc_read(ch);
+
+        twi_slave_set(REG_ADC0 + 2 * ch, value);
+        stats_update(g_streams[2 + ch].stats, value);
+    }
+    twi_slave_set(REG_FRAMES, stats->frames);
+    twi_slave_set(REG_I2C_ERR, stats->i2c_errors);
+    twi_slave_set(REG_CRC_ERR, stats->crc_errors);
+    twi_slave_set(REG_UPTIME, timer_millis() / 1000);
+}
+
+static void aht20_poll_dev(t_bus_dev *dev)
+{
+    uint8_t event = aht20_poll();
+
+    if (event == AHT20_EVT_NONE)
+        return;
+    // Une trame au CRC faux a quand même été échangée sans erreur I2C
+    bus_report(dev, event != AHT20_EVT_ERROR);
+    if (event == AHT20_EVT_DATA)
+        aht20_print_data();
+    else
+        aht20_print_errors(event);
+    if (!dev->present)
+        uart_println("AHT20: absent, nouvel essai dans 5s");
+}
+
+static t_bus_dev g_devices[] =
+{
+    {"AHT20", AHT20_ADDR, aht20_start, aht20_poll_dev, 0, 0, 0},
+};
+
+/* Adresses qui répondent sur le bus, et périphériques connus absents */
+static void bus_print(void)
+{
+    uint8_t found[8];
+    uint8_t n = bus_scan(found, sizeof(found));
+
+    uart_printstr("Bus I2C :");
+    for (uint8_t i = 0; i < n && i < sizeof(found); i++)
+    {
+        uart_printstr(" 0x");
+        uart_printhex(found[i]);
+    }
+    if (!n)
+        uart_printstr(" aucun peripherique");
+    uart_println("");
+    for (uint8_t i = 0; i < sizeof(g_devices) / sizeof(g_devices[0]); i++)
+    {
+        if (g_devices[i].present)
+            continue;
+        uart_printstr(g_devices[i].name);
+        uart_println(" absent");
+    }
+}
+
+/* Terminal série : une ligne de statistiques par grandeur
+ * nom n=<échantillons>/<fenêtre> moy min max var (variance en unité²)
+ */
+static void shell_print_stats(void)
+{
+    for (uint8_t i = 0; i < NB_STREAMS; i++)
+    {
+        const t_stats *s = g_streams[i].stats;
+        uint8_t        dec = g_streams[i].decimals;
+
+        uart_printstr(g_streams[i].name);
+        uart_printstr(" n=");
+        uart_printfixed(s->n, 0);
+        uart_tx('/');
+        uart_printfixed(s->window, 0);
+        uart_printstr(" moy ");
+        uart_printfixed(stats_mean(s), dec);
+        uart_printstr(" min ");
+        uart_printfixed(stats_min(s), dec);
+        uart_printstr(" max ");
+        uart_printfixed(stats_max(s), dec);
+        uart_printstr(" var ");
+        // Centièmes² : 4 décimales. Plafonnée pour l'affichage signé
+        uart_printfixed(stats_variance(s) > 0x7FFFFFFF
+                        ? 0x7FFFFFFF : (int32_t)stats_variance(s), 2 * dec);
+        uart_println("");
+    }
+}
+
+/* Même fenêtre pour toutes les grandeurs, ramenée à la taille du buffer
+ * de chacune (STATS_AHT20_SIZE, STATS_ADC_SIZE) : on affiche la fenêtre
+ * obtenue par chaque grandeur
+ */
+static void shell_set_window(const char *arg)
+{
+    uint16_t n = 0;
+
+    while (*arg >= '0' && *arg <= '9' && n <= STATS_MAX_WINDOW)
+        n = n * 10 + (*arg++ - '0');
+    if (*arg || n == 0 || n > STATS_MAX_WINDOW)
+    {
+        uart_println("fenetre invalide (1 a 64)");
+        return;
+    }
+    uart_printstr("fenetre :");
+    for (uint8_t i = 0; i < NB_STREAMS; i++)
+    {
+        t_stats *s = g_streams[i].stats;
+
+        stats_set_window(s, n > s->size ? s->size : n);
+        uart_tx(' ');
+        uart_printstr(g_streams[i].name);
+        uart_tx(' ');
+        uart_printfixed(s->window, 0);
+        if (s->window < n)
+            uart_printstr(" (max)");
+    }
+    uart_println("");
+    uart_println("statistiques remises a zero");
+}
+
+static void shell_command(const char *line)
+{
+    if (line[0] == 's' && line[1] == '\0')
+        shell_print_stats();
+    else if (line[0] == 'w' && line[1] == ' ')
+        shell_set_window(line + 2);
+    else if (line[0] == 'r' && line[1] == '\0')
+    {
+        for (uint8_t i = 0; i < NB_STREAMS; i++)
+            stats_reset(g_streams[i].stats);
+        uart_println("statistiques remises a zero");
+    }
+    else if (line[0])
+        uart_println("commandes : s (statistiques), w <n> (fenetre), r (raz)");
+}
+
+/* Saisie d'une ligne, même édition que Module05/ex03 */
+static void shell_poll(void)
+{
+    static char    line[SHELL_LINE_SIZE];
+    static uint8_t len = 0;
+    char           c;
+
+    if (!uart_rx_ready())
+        return;
+    c = uart_rx();
+    if (c == '\r' || c == '\n')
+    {
+        uart_printstr("\r\n");
+        line[len] = '\0';
+        shell_command(line);
+        len = 0;
+    }
+    else if ((c == '\b' || c == 127) && len > 0)
+    {
+        len--;
+        uart_printstr("\b \b");
+    }
+    else if (c >= ' ' && len < SHELL_LINE_SIZE - 1)
+    {
+        line[len++] = c;
+        uart_tx(c);
+    }
+}
+
+int main(void)
+{
+    uint32_t blink = 0;
+    uint32_t adc_ms = 0;
+    
+    uart_init();
+    i2c_init();
+    timer_init();
+    adc_init();
+
+    // Répond aussi comme esclave à SLAVE_ADDR (carte de registres)
+    twi_slave_init(SLAVE_ADDR, REG_SIZE);
+    twi_slave_set(REG_ID, SLAVE_ID);
+
+    // Moyenne affichée sur les dernières mesures seulement
+    stats_set_window(&g_temp, STATS_AHT20_WINDOW);
+    stats_set_window(&g_hum, STATS_AHT20_WINDOW);
+
+    // LED D1 (PB0) : clignote tant que la boucle n'est pas bloquée
+    DDRB |= (1 << PB0);
+
+    // Active les interruptions : l'ISR USART_UDRE vide le buffer d'émission,
+    // l'ISR TWI déroule les transferts, Timer0 compte les millisecondes
+    sei();
+
+    // Capteurs alimentés depuis 40ms avant de les sonder
+    _delay_ms(AHT20_POWERUP_MS);
+    bus_register(g_devices, sizeof(g_devices) / sizeof(g_devices[0]));
+    bus_print();
+    set_sleep_mode(SLEEP_MODE_IDLE);
+    
+    while (1)
+    {
+        // Pilotes des périphériques présents (AHT20 : aht20_poll_dev)
+        bus_poll();
+
+        // Le reste de la boucle est libre pendant la conversion du capteur
+        shell_poll();
+        if ((uint32_t)(timer_millis() - adc_ms) >= ADC_PERIOD_MS)
         {
-            i2c_read();  // Lit dans TWDR avec ACK
-            data[i] = TWDR;
+            adc_ms += ADC_PERIOD_MS;
+            slave_update();
         }
-        
-        // Lire le 7ème octet avec NACK (dernier)
-        i2c_read_last();
-        data[6] = TWDR;
-        
-        i2c_stop();
-        
-        // Calculer température et humidité
-        float temperature = calculate_temperature(data);
-        float humidity = calculate_humidity(data);
-        
-        // Stocker dans l'historique
-        temp_history[measure_count % 3] = temperature;
-        hum_history[measure_count % 3] = humidity;
-        measure_count++;
-        
-        // Calculer la moyenne des 3 dernières mesures
-        float temp_avg = 0;
-        float hum_avg = 0;
-        uint8_t count = (measure_count < 3) ? measure_count : 3;
-        
-        for (uint8_t i = 0; i < count; i++)
+        if ((uint32_t)(timer_millis() - blink) >= HEARTBEAT_MS)
         {
-            temp_avg += temp_history[i];
-            hum_avg += hum_history[i];
+            blink += HEARTBEAT_MS;
+            PORTB ^= (1 << PB0);
         }
-        
-        temp_avg /= count;
-        hum_avg /= count;
-        
-        // Afficher le résultat
-        // Format: "Temperature: XX.X°C, Humidity: XX.X%"
-        uart_printstr("Temperature: ");
-        uart_printfloat(temp_avg, 1);  // 1 décimale
-        uart_printstr("C, Humidity: ");
-        uart_printfloat(hum_avg, 1);   // 1 décimale
-        uart_println("%");
-        
-        // Attendre 1 seconde avant la prochaine mesure
-        _delay_ms(1000);
+
+        // Veille jusqu'à la prochaine interruption (Timer0 : 1ms au plus)
+        sleep_mode();
     }
     
     return 0;
 }
 
+#endif
@@ -16,45 +16,136 @@
 #include <avr/io.h>
 #include <util/twi.h>
 #include <util/delay.h>
+#include <avr/interrupt.h>
+#include <avr/sleep.h>
 #include "aht20.h"
+#include "stats.h"
+#include "twi.h"
+#include "bus.h"
 
 # define UART_BAUDRATE 115200
 
 #define I2C_WRITE 0
 #define I2C_READ  1
 
+# define HEARTBEAT_MS 500     // LED D1 : la boucle principale tourne
+
 /* I2C */
 
 // Initialise l'interface I2C/TWI du microcontrôleur
 void i2c_init(void);
 
+/* Chaque appel retourne TWI_OK ou un code TWI_ERR_* (twi.h) : jamais
+ * plus de TWI_PHASE_TIMEOUT_US d'attente, même bus bloqué
+ */
+
 // Démarre une transmission I2C (condition START)
-void i2c_start(void);
+uint8_t i2c_start(void);
 
 // Termine une transmission I2C (condition STOP)
-void i2c_stop(void);
+uint8_t i2c_stop(void);
 
 /* utiles pour faciliter la communication*/
 
 // Écrit le contenu du registre TWDR et l'envoie au capteur
-void i2c_write(unsigned char data);
+uint8_t i2c_write(unsigned char data);
 
 // Affiche le contenu du registre TWDR après la mesure par le capteur (avec ACK)
-void i2c_read(void);
+uint8_t i2c_read(void);
 
 // Lit le dernier octet avec NACK
-void i2c_read_last(void);
+uint8_t i2c_read_last(void);
 
 // Retourne le status I2C
 uint8_t i2c_get_status(void);
 
 
+/* Esclave I2C : un autre maître lit les dernières mesures de la carte
+ * (twi_slave_*). Registres 16 bits, poids fort d'abord
+ */
+# ifndef SLAVE_ADDR
+#  define SLAVE_ADDR    0x42    // une adresse différente par carte
+# endif
+# define REG_ID         0x00    // SLAVE_ID : vérifie qu'on lit la bonne carte
+# define REG_ADC0       0x02    // RV1, 10 bits
+# define REG_ADC1       0x04    // LDR
+# define REG_ADC2       0x06    // NTC
+# define REG_TEMP       0x08    // AHT20, centièmes de °C (signé)
+# define REG_HUM        0x0A    // AHT20, centièmes de %RH
+# define REG_FRAMES     0x0C    // trames AHT20 valides
+# define REG_I2C_ERR    0x0E    // erreurs I2C du pilote AHT20
+# define REG_CRC_ERR    0x10    // trames AHT20 au CRC faux
+# define REG_UPTIME     0x12    // secondes depuis le démarrage
+# define REG_SIZE       0x14
+# define SLAVE_ID       0x4D36  // "M6"
+# define ADC_PERIOD_MS  100
+
+/* Statistiques glissantes (stats.c), consultées par le terminal série :
+ * AHT20 en centièmes, une mesure par seconde ; ADC brut toutes les 100ms.
+ * SIZE fixe la RAM (4 octets par échantillon), la fenêtre se règle
+ * ensuite (commande "w", ramenée à SIZE)
+ */
+# define STATS_AHT20_SIZE   16
+# define STATS_AHT20_WINDOW 4       // moyenne affichée : 4 dernières mesures
+# define STATS_ADC_SIZE     32
+# define SHELL_LINE_SIZE    16
+
+/* ADC (adc.c) : lecture bloquante d'un canal, 104µs */
+void adc_init(void);
+uint16_t adc_read(uint8_t channel);
+
+
+/* Timer0 : base de temps 1ms (timer.c) */
+void timer_init(void);
+uint32_t timer_millis(void);
+uint32_t timer_micros(void);
+
+
 /* UART */
 
+/* Buffer circulaire d'émission (vidé par l'interruption USART_UDRE)
+ * UART_TX_SIZE doit être une puissance de 2 (index masqué, pas de modulo)
+ */
+# ifndef UART_TX_SIZE
+#  define UART_TX_SIZE 64
+# endif
+# define UART_TX_MASK (UART_TX_SIZE - 1)
+# if (UART_TX_SIZE & UART_TX_MASK) || UART_TX_SIZE > 256
+#  error "UART_TX_SIZE doit être une puissance de 2 <= 256"
+# endif
+
+/* Politique quand le buffer est plein (-DUART_TX_POLICY=... dans CFLAGS)
+ * BLOCK     : attend qu'une place se libère (aucune perte)
+ * DROP      : jette le nouvel octet
+ * OVERWRITE : écrase l'octet le plus ancien encore en attente
+ */
+# define UART_TX_BLOCK      0
+# define UART_TX_DROP       1
+# define UART_TX_OVERWRITE  2
+# ifndef UART_TX_POLICY
+#  define UART_TX_POLICY UART_TX_BLOCK
+# endif
+
 void uart_init(void);
 
+// Met un caractère en file d'émission (retour immédiat)
 void uart_tx(char c);
 
+// Met len octets en file, retourne le nombre d'octets acceptés
+uint8_t uart_write(const char *buf, uint8_t len);
+
+// Attend la fin de l'émission de tout le buffer
+void uart_flush(void);
+
+// Octets perdus/écrasés (politiques DROP / OVERWRITE)
+uint16_t uart_tx_overflows(void);
+
+// 1 si un octet reçu attend dans UDR0
+uint8_t uart_rx_ready(void);
+
+// Octet reçu (attend s'il n'y en a pas)
+char uart_rx(void);
+
 void uart_printhex(uint8_t value);
 
 void uart_printstr(const char* str);
@@ -65,7 +156,7 @@ void uart_println(const char *str);
 /* Écrit le contenu des 7 octets d'une mesure AHT20 en hexa */
 void print_hex_value(char *c);
 
-/*  Affiche un float avec précision donnée */
-void uart_printfloat(float value, uint8_t precision);
+/* Affiche value / 10^decimals, ex: (2153, 2) -> "21.53" */
+void uart_printfixed(int32_t value, uint8_t decimals);
 
 #endif
\ No newline at end of file
@@ -0,0 +1,135 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   stats.c                                            :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: cmetee-b <cmetee-b@student.42.fr>          +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2025/11/30 10:24:05 by cmetee-b          #+#    #+#             */
+/*   Updated: 2025/11/30 16:11:52 by cmetee-b         ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+#include "stats.h"
+
+void stats_reset(t_stats *s)
+{
+    s->sum = 0;
+    s->sumsq = 0;
+    s->pos = 0;
+    s->n = 0;
+    s->min_head = 0;
+    s->min_len = 0;
+    s->max_head = 0;
+    s->max_len = 0;
+}
+
+uint8_t stats_set_window(t_stats *s, uint8_t window)
+{
+    if (window == 0 || window > s->size)
+        return 0;
+    s->window = window;
+    stats_reset(s);
+    return 1;
+}
+
+/* Index suivant dans une fenêtre circulaire de window cases (pas de modulo) */
+static uint8_t stats_next(const t_stats *s, uint8_t i)
+{
+    return (i + 1 == s->window) ? 0 : i + 1;
+}
+
+/* Position de la case i après la tête d'une file */
+static uint8_t stats_at(const t_stats *s, uint8_t head, uint8_t i)
+{
+    i += head;
+    return (i >= s->window) ? i - s->window : i;
+}
+
+/* File monotone : on retire par la fin les positions que x rend inutiles
+ * (elles sortiront de la fenêtre avant x sans jamais redevenir min/max),
+ * puis on ajoute la position de x. Chaque position entre et sort une fois.
+ * less = 1 pour le min (valeurs croissantes), 0 pour le max
+ */
+static void stats_push(t_stats *s, uint8_t *q, uint8_t head, uint8_t *len,
+                       int16_t x, uint8_t less)
+{
+    while (*len)
+    {
+        int16_t back = s->buf[q[stats_at(s, head, *len - 1)]];
+
+        if (less ? back < x : back > x)
+            break;
+        (*len)--;
+    }
+    q[stats_at(s, head, *len)] = s->pos;
+    (*len)++;
+}
+
+void stats_update(t_stats *s, int16_t x)
+{
+    /* Fenêtre pleine : buf[pos] est le plus ancien, il sort. S'il est en
+     * tête d'une file il en sort aussi (ailleurs il en a déjà été retiré)
+     */
+    if (s->n == s->window)
+    {
+        int16_t old = s->buf[s->pos];
+
+        s->sum -= old;
+        s->sumsq -= (uint32_t)((int32_t)old * old);
+        if (s->min_len && s->qmin[s->min_head] == s->pos)
+        {
+            s->min_head = stats_next(s, s->min_head);
+            s->min_len--;
+        }
+        if (s->max_len && s->qmax[s->max_head] == s->pos)
+        {
+            s->max_head = stats_next(s, s->max_head);
+            s->max_len--;
+        }
+    }
+    else
+        s->n++;
+
+    /* Files mises à jour avant l'écriture : elles comparent avec buf */
+    stats_push(s, s->qmin, s->min_head, &s->min_len, x, 1);
+    stats_push(s, s->qmax, s->max_head, &s->max_len, x, 0);
+    s->buf[s->pos] = x;
+    s->sum += x;
+    s->sumsq += (uint32_t)((int32_t)x * x);
+    s->pos = stats_next(s, s->pos);
+}
+
+int16_t stats_min(const t_stats *s)
+{
+    return s->min_len ? s->buf[s->qmin[s->min_head]] : 0;
+}
+
+int16_t stats_max(const t_stats *s)
+{
+    return s->max_len ? s->buf[s->qmax[s->max_head]] : 0;
+}
+
+int16_t stats_mean(const t_stats *s)
+{
+    if (!s->n)
+        return 0;
+    /* Arrondi au plus proche, y compris pour une somme négative */
+    if (s->sum < 0)
+        return (s->sum - s->n / 2) / s->n;
+    return (s->sum + s->n / 2) / s->n;
+}
+
+uint32_t stats_variance(const t_stats *s)
+{
+    uint64_t var;
+
+    if (!s->n)
+        return 0;
+    /* var = (N * Σx² - (Σx)²) / N², exacte en entiers (>= 0 par
+     * construction), comme le banc ADC de Module05
+     */
+    var = s->sumsq * s->n - (uint64_t)((int64_t)s->sum * s->sum);
+    var /= (uint16_t)s->n * s->n;
+    return (var > 0xFFFFFFFF) ? 0xFFFFFFFF : (uint32_t)var;
+}
@@ -0,0 +1,72 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   stats.h                                            :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: cmetee-b <cmetee-b@student.42.fr>          +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2025/11/30 10:24:05 by cmetee-b          #+#    #+#             */
+/*   Updated: 2025/11/30 16:11:52 by cmetee-b         ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+#ifndef STATS_H
+#define STATS_H
+
+#include <stdint.h>
+
+/* Statistiques glissantes sur les N derniers échantillons (N <= 64)
+ * min, max, moyenne et variance en O(1) par échantillon, sans float :
+ *   - somme et somme des carrés entretenues (le plus ancien sort,
+ *     le nouveau entre), comme FILTER_BOX
+ *   - min et max par files monotones : une position n'y entre et n'en
+ *     sort qu'une fois, on ne reparcourt jamais la fenêtre
+ * La taille des buffers est fixée à la compilation, la fenêtre utilisée
+ * peut être réduite ensuite (stats_set_window).
+ * Même code dans Module06/ex02, au style de ce dossier (anglais, tabulations).
+ */
+#define STATS_MAX_WINDOW 64
+
+typedef struct s_stats
+{
+    int16_t  *buf;          // derniers échantillons (fenêtre circulaire)
+    uint8_t  *qmin;         // positions dans buf, valeurs croissantes
+    uint8_t  *qmax;         // positions dans buf, valeurs décroissantes
+    int32_t   sum;
+    uint64_t  sumsq;        // 64 * 32768² dépasse 32 bits
+    uint8_t   size;         // taille des buffers
+    uint8_t   window;       // fenêtre utilisée, <= size
+    uint8_t   pos;          // prochaine case de buf
+    uint8_t   n;            // échantillons reçus (jusqu'à window)
+    uint8_t   min_head;
+    uint8_t   min_len;
+    uint8_t   max_head;
+    uint8_t   max_len;
+} t_stats;
+
+/* Buffers déclarés avec l'accumulateur, fenêtre = size au départ :
+ *     STATS(g_pot, 32);       // 32 derniers échantillons, 128 octets
+ */
+#define STATS(name, size) \
+    static int16_t name##_buf[(size)]; \
+    static uint8_t name##_qmin[(size)]; \
+    static uint8_t name##_qmax[(size)]; \
+    static t_stats name = {name##_buf, name##_qmin, name##_qmax, \
+                           0, 0, (size), (size), 0, 0, 0, 0, 0, 0}
+
+/* Vide la fenêtre (min/max/moyenne repartent du prochain échantillon) */
+void     stats_reset(t_stats *s);
+
+/* Nouvelle fenêtre (1..size) : retourne 0 si hors limites. Vide la fenêtre */
+uint8_t  stats_set_window(t_stats *s, uint8_t window);
+
+/* Ajoute x et retire le plus ancien si la fenêtre est pleine */
+void     stats_update(t_stats *s, int16_t x);
+
+/* Résultats sur les échantillons présents (0 si aucun) */
+int16_t  stats_min(const t_stats *s);
+int16_t  stats_max(const t_stats *s);
+int16_t  stats_mean(const t_stats *s);          // arrondie
+uint32_t stats_variance(const t_stats *s);      // population, unité²
+
+#endif
@@ -0,0 +1,500 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   twi.c                                              :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: cmetee-b <cmetee-b@student.42.fr>          +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2025/11/27 10:05:33 by cmetee-b          #+#    #+#             */
+/*   Updated: 2025/11/27 18:41:07 by cmetee-b         ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include <avr/sleep.h>
+#include <util/twi.h>
+#include <util/delay.h>
+#include "main.h"
+#include "twi.h"
+
+/* Broches du bus (PC4 = SDA, PC5 = SCL), utilisées en GPIO pendant
+ * twi_recover : sortie à 0 ou entrée (relâchée, tirée par les pull-ups)
+ */
+#define TWI_SDA     PC4
+#define TWI_SCL     PC5
+#define TWI_HALF_US 5           // demi-période SCL du déblocage (100kHz)
+
+/* TWCR pour chaque action (21.9.2), TWIE toujours à 1 pendant la
+ * transaction : l'ISR est appelée à chaque fois que TWINT passe à 1
+ */
+#define TWCR_START  ((1 << TWINT) | (1 << TWSTA) | (1 << TWEN) | (1 << TWIE))
+#define TWCR_NEXT   ((1 << TWINT) | (1 << TWEN) | (1 << TWIE))
+#define TWCR_ACK    ((1 << TWINT) | (1 << TWEA) | (1 << TWEN) | (1 << TWIE))
+#define TWCR_STOP   ((1 << TWINT) | (1 << TWSTO) | (1 << TWEN))
+#define TWCR_FREE   ((1 << TWINT) | (1 << TWEN))
+
+static t_twi_xfer * volatile current = 0;
+static uint8_t               widx;
+static uint8_t               ridx;
+static volatile uint32_t     phase_us;  // début de la phase en cours
+static uint32_t              start_us;  // début de la transaction
+
+static t_twi_stats g_stats __attribute__((section(".noinit")));
+
+/* Esclave : carte de registres écrite par le main (live) et copie
+ * figée au début de chaque lecture par le maître (shadow), pour qu'une
+ * valeur 16 bits ne soit jamais lue à moitié mise à jour
+ */
+static uint8_t          slave_idle = 0;     // TWEA | TWIE si esclave actif
+static volatile uint8_t slave_active = 0;   // adressé, pas encore de STOP
+static uint8_t          slave_live[TWI_SLAVE_SIZE];
+static uint8_t          slave_shadow[TWI_SLAVE_SIZE];
+static uint8_t          slave_size = 0;
+static uint8_t          slave_ptr = 0;      // registre courant
+static uint8_t          slave_first;        // 1 : octet reçu = n° de registre
+static volatile uint16_t slave_reads = 0;
+
+static void twi_finish(uint8_t status, uint8_t twcr)
+{
+    t_twi_xfer *xfer = current;
+
+    /* STOP (ou bus rendu) et TWIE coupé : plus d'interruption, sauf en
+     * mode esclave où le TWI doit continuer à répondre à son adresse
+     */
+    TWCR = twcr | slave_idle;
+    current = 0;
+    xfer->us = timer_micros() - start_us;
+    twi_record(status);
+    xfer->status = status;
+    if (xfer->callback)
+        xfer->callback(xfer);
+}
+
+/* SLA+R avec ACK/NACK préparé pour le premier octet : NACK tout de
+ * suite si un seul octet est attendu (Table 21-4)
+ */
+static uint8_t twi_read_ack(void)
+{
+    return (ridx + 1 < current->rlen) ? TWCR_ACK : TWCR_NEXT;
+}
+
+/* Octet suivant de la carte pour le maître, 0xFF au-delà de la fin */
+static uint8_t twi_slave_next(void)
+{
+    uint8_t value = 0xFF;
+
+    if (slave_ptr < slave_size)
+        value = slave_shadow[slave_ptr];
+    slave_ptr++;
+    return value;
+}
+
+/* Un autre maître nous parle : Table 21-5 (récepteur esclave) et
+ * 21-6 (émetteur esclave). Premier octet écrit = n° de registre, les
+ * lectures suivantes avancent toutes seules (auto-incrément).
+ * La carte est en lecture seule : les autres octets écrits sont ignorés
+ */
+static void twi_slave_isr(uint8_t status)
+{
+    switch (status)
+    {
+        case TW_SR_SLA_ACK:
+        case TW_SR_ARB_LOST_SLA_ACK:
+        case TW_SR_GCALL_ACK:
+        case TW_SR_ARB_LOST_GCALL_ACK:
+            slave_active = 1;
+            slave_first = 1;
+            break;
+
+        case TW_SR_DATA_ACK:
+        case TW_SR_GCALL_DATA_ACK:
+            if (slave_first)
+                slave_ptr = TWDR;
+            slave_first = 0;
+            break;
+
+        case TW_ST_SLA_ACK:
+        case TW_ST_ARB_LOST_SLA_ACK:
+            slave_active = 1;
+            for (uint8_t i = 0; i < slave_size; i++)
+                slave_shadow[i] = slave_live[i];
+            slave_reads++;
+            TWDR = twi_slave_next();
+            break;
+
+        case TW_ST_DATA_ACK:
+            TWDR = twi_slave_next();
+            break;
+
+        default:
+            /* TW_SR_STOP, TW_SR_*_NACK, TW_ST_DATA_NACK, TW_ST_LAST_DATA :
+             * fin de l'échange, on se remet en attente de notre adresse
+             */
+            slave_active = 0;
+            break;
+    }
+    TWCR = TWCR_NEXT | slave_idle;
+}
+
+/* Vecteur 24 - TWI : une étape de la transaction par interruption
+ * Codes d'état : Table 21-3 (émetteur) et 21-4 (récepteur), 0x60 à
+ * 0xC8 : esclave
+ */
+ISR(TWI_vect)
+{
+    t_twi_xfer *xfer = current;
+    uint8_t     status = TW_STATUS;
+
+    if (status >= TW_SR_SLA_ACK && status <= TW_ST_LAST_DATA)
+    {
+        /* Arbitrage perdu pendant notre SLA, et c'est nous qui sommes
+         * adressés : la transaction maître s'arrête (à relancer)
+         */
+        if (xfer)
+        {
+            current = 0;
+            xfer->twsr = status;
+            twi_record(TWI_ERR_ARB_LOST);
+            xfer->status = TWI_ERR_ARB_LOST;
+            if (xfer->callback)
+                xfer->callback(xfer);
+        }
+        twi_slave_isr(status);
+        return;
+    }
+    if (!xfer)
+    {
+        /* Étape maître d'une transaction déjà terminée (timeout) : le bus
+         * est encore à nous, on le rend avec un STOP. Arbitrage perdu :
+         * il est à l'autre maître, on se retire seulement
+         */
+        if (status == TW_MT_ARB_LOST || status == TW_NO_INFO)
+            TWCR = TWCR_FREE | slave_idle;
+        else
+            TWCR = TWCR_STOP | slave_idle;
+        return;
+    }
+    xfer->twsr = status;
+    phase_us = timer_micros();
+
+    switch (status)
+    {
+        case TW_START:
+        case TW_REP_START:
+            /* Écriture d'abord (ou sonde), lecture après le repeated START */
+            if (widx < xfer->wlen || xfer->rlen == 0)
+                TWDR = (xfer->addr << 1) | TW_WRITE;
+            else
+                TWDR = (xfer->addr << 1) | TW_READ;
+            TWCR = TWCR_NEXT;
+            break;
+
+        case TW_MT_SLA_ACK:
+        case TW_MT_DATA_ACK:
+            if (widx < xfer->wlen)
+            {
+                TWDR = xfer->wbuf[widx++];
+                TWCR = TWCR_NEXT;
+            }
+            else if (xfer->rlen)
+                TWCR = TWCR_START;      // repeated START, le bus reste à nous
+            else
+                twi_finish(TWI_OK, TWCR_STOP);
+            break;
+
+        case TW_MR_SLA_ACK:
+            TWCR = twi_read_ack();
+            break;
+
+        case TW_MR_DATA_ACK:
+            xfer->rbuf[ridx++] = TWDR;
+            TWCR = twi_read_ack();
+            break;
+
+        case TW_MR_DATA_NACK:
+            /* Dernier octet (NACK envoyé par nous) */
+            xfer->rbuf[ridx++] = TWDR;
+            twi_finish(TWI_OK, TWCR_STOP);
+            break;
+
+        case TW_MT_SLA_NACK:
+        case TW_MR_SLA_NACK:
+            twi_finish(TWI_ERR_NACK_ADDR, TWCR_STOP);
+            break;
+
+        case TW_MT_DATA_NACK:
+            twi_finish(TWI_ERR_NACK_DATA, TWCR_STOP);
+            break;
+
+        case TW_MT_ARB_LOST:
+            /* Bus rendu sans STOP : il appartient à l'autre maître */
+            twi_finish(TWI_ERR_ARB_LOST, TWCR_FREE);
+            break;
+
+        default:
+            /* TW_BUS_ERROR : STOP interne, le TWI relâche les lignes */
+            twi_finish(twi_error(status), TWCR_STOP);
+            break;
+    }
+}
+
+uint8_t twi_submit(t_twi_xfer *xfer)
+{
+    uint8_t sreg = SREG;
+
+    if (current)
+        return 0;
+
+    /* STOP précédent pas encore sorti sur le bus (quelques µs) */
+    phase_us = timer_micros();
+    while (TWCR & (1 << TWSTO))
+    {
+        if (timer_micros() - phase_us >= TWI_PHASE_TIMEOUT_US)
+        {
+            twi_recover();
+            break;
+        }
+    }
+
+    /* Dernier test et START sans interruption : un maître extérieur qui
+     * nous adresse entre les deux trouverait sinon une transaction
+     * publiée mais pas encore lancée, et l'ISR l'abandonnerait
+     */
+    cli();
+    /* Bus pris par une autre transaction, ou un maître extérieur en train
+     * de nous parler (ou sur le point de le faire : TWINT déjà levé)
+     */
+    if (current || slave_active || (slave_idle && (TWCR & (1 << TWINT))))
+    {
+        SREG = sreg;
+        return 0;
+    }
+    widx = 0;
+    ridx = 0;
+    xfer->status = TWI_BUSY;
+    xfer->twsr = TW_NO_INFO;
+    phase_us = timer_micros();
+    start_us = phase_us;
+    current = xfer;
+    /* TWEA gardé en mode esclave : si on perd l'arbitrage face à un
+     * maître qui nous adresse, on lui répond
+     */
+    TWCR = TWCR_START | slave_idle;
+    SREG = sreg;
+    return 1;
+}
+
+void twi_slave_init(uint8_t addr, uint8_t size)
+{
+    uint8_t sreg = SREG;
+
+    if (size > TWI_SLAVE_SIZE)
+        size = TWI_SLAVE_SIZE;
+    cli();
+    slave_size = size;
+    slave_ptr = 0;
+    /* TWAR : adresse 7 bits, TWGCE (bit 0) = 0, pas d'appel général */
+    TWAR = addr << 1;
+    slave_idle = (1 << TWEA) | (1 << TWIE);
+    if (!current)
+        TWCR = (1 << TWEN) | slave_idle;
+    SREG = sreg;
+}
+
+void twi_slave_set(uint8_t reg, uint16_t value)
+{
+    uint8_t sreg = SREG;
+
+    if (reg + 1 >= TWI_SLAVE_SIZE)
+        return;
+    /* Poids fort d'abord ; copie vers shadow par l'ISR, donc section
+     * critique pour ne pas figer un seul des deux octets
+     */
+    cli();
+    slave_live[reg] = value >> 8;
+    slave_live[reg + 1] = value & 0xFF;
+    SREG = sreg;
+}
+
+uint16_t twi_slave_reads(void)
+{
+    uint16_t n;
+    uint8_t  sreg = SREG;
+
+    cli();
+    n = slave_reads;
+    SREG = sreg;
+    return n;
+}
+
+uint8_t twi_busy(void)
+{
+    return current != 0;
+}
+
+uint8_t twi_poll(void)
+{
+    uint8_t sreg = SREG;
+
+    if (!current)
+        return 0;
+    if (timer_micros() - phase_us < TWI_PHASE_TIMEOUT_US)
+        return 1;
+
+    /* Phase trop longue : l'ISR ne sera plus appelée, on termine à sa
+     * place (section critique : elle pourrait arriver pendant ce temps)
+     */
+    cli();
+    if (current && timer_micros() - phase_us >= TWI_PHASE_TIMEOUT_US)
+    {
+        current->twsr = TW_STATUS;
+        twi_recover();
+        twi_finish(TWI_ERR_TIMEOUT, TWCR_FREE);
+    }
+    SREG = sreg;
+    return current != 0;
+}
+
+uint8_t twi_wait(t_twi_xfer *xfer)
+{
+    uint8_t sreg = SREG;
+
+    /* Timer0 réveille le CPU chaque milliseconde : le timeout est
+     * vérifié même si l'interruption TWI n'arrive jamais
+     */
+    set_sleep_mode(SLEEP_MODE_IDLE);
+    while (1)
+    {
+        twi_poll();
+        cli();
+        if (xfer->status != TWI_BUSY)
+            break;
+        /* sei() puis sleep_cpu() : pas de réveil perdu entre le test et
+         * la mise en veille
+         */
+        sleep_enable();
+        sei();
+        sleep_cpu();
+        sleep_disable();
+    }
+    SREG = sreg;
+    return xfer->status;
+}
+
+uint8_t twi_wait_twint(void)
+{
+    uint32_t start = timer_micros();
+
+    while (!(TWCR & (1 << TWINT)))
+    {
+        if (timer_micros() - start >= TWI_PHASE_TIMEOUT_US)
+        {
+            twi_record(TWI_ERR_TIMEOUT);
+            twi_recover();
+            return TWI_ERR_TIMEOUT;
+        }
+    }
+    return TWI_OK;
+}
+
+uint8_t twi_set_bitrate(uint16_t setting)
+{
+    if (current)
+        return 0;
+    TWBR = setting & 0xFF;
+    /* TWPS1:0 seuls bits écrivables de TWSR (21.9.3) */
+    TWSR = (setting >> 8) & 0x03;
+    return 1;
+}
+
+uint32_t twi_bitrate_hz(void)
+{
+    uint8_t ps = TWSR & 0x03;
+
+    return F_CPU / (16 + 2UL * TWBR * (1 << (2 * ps)));
+}
+
+uint8_t twi_error(uint8_t twsr)
+{
+    switch (twsr & TW_STATUS_MASK)
+    {
+        case TW_MT_SLA_NACK:
+        case TW_MR_SLA_NACK:
+            return TWI_ERR_NACK_ADDR;
+        case TW_MT_DATA_NACK:
+            return TWI_ERR_NACK_DATA;
+        case TW_MT_ARB_LOST:
+            return TWI_ERR_ARB_LOST;
+        case TW_BUS_ERROR:
+            return TWI_ERR_BUS;
+        default:
+            return TWI_ERR_STATUS;
+    }
+}
+
+uint8_t twi_recover(void)
+{
+    uint8_t twbr = TWBR;
+    uint8_t free;
+
+    g_stats.recoveries++;
+    /* TWI coupé : PC4/PC5 redeviennent des GPIO. PORT à 0 : en sortie la
+     * ligne est tirée à 0, en entrée elle est relâchée (drain ouvert)
+     */
+    TWCR = 0;
+    PORTC &= ~((1 << TWI_SDA) | (1 << TWI_SCL));
+    DDRC &= ~((1 << TWI_SDA) | (1 << TWI_SCL));
+    _delay_us(TWI_HALF_US);
+
+    /* L'esclave finit l'octet qu'il croit en cours : au plus 9 coups
+     * d'horloge (8 bits + ACK) avant qu'il relâche SDA
+     */
+    for (uint8_t i = 0; i < 9 && !(PINC & (1 << TWI_SDA)); i++)
+    {
+        DDRC |= (1 << TWI_SCL);
+        _delay_us(TWI_HALF_US);
+        DDRC &= ~(1 << TWI_SCL);
+        _delay_us(TWI_HALF_US);
+    }
+
+    /* STOP : SDA monte pendant que SCL est haut */
+    DDRC |= (1 << TWI_SCL);
+    _delay_us(TWI_HALF_US);
+    DDRC |= (1 << TWI_SDA);
+    _delay_us(TWI_HALF_US);
+    DDRC &= ~(1 << TWI_SCL);
+    _delay_us(TWI_HALF_US);
+    DDRC &= ~(1 << TWI_SDA);
+    _delay_us(TWI_HALF_US);
+
+    free = (PINC & (1 << TWI_SDA)) && (PINC & (1 << TWI_SCL));
+    if (!free)
+        g_stats.stuck++;
+
+    TWBR = twbr;
+    TWCR = (1 << TWEN) | slave_idle;
+    return free;
+}
+
+void twi_record(uint8_t status)
+{
+    if (status < TWI_NB_STATUS)
+        g_stats.count[status]++;
+}
+
+void twi_stats_init(void)
+{
+    if (g_stats.magic == TWI_STATS_MAGIC)
+        return;
+    for (uint8_t i = 0; i < TWI_NB_STATUS; i++)
+        g_stats.count[i] = 0;
+    g_stats.recoveries = 0;
+    g_stats.stuck = 0;
+    g_stats.magic = TWI_STATS_MAGIC;
+}
+
+const t_twi_stats *twi_stats(void)
+{
+    return &g_stats;
+}
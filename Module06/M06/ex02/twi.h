@@ -0,0 +1,198 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   twi.h                                              :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: cmetee-b <cmetee-b@student.42.fr>          +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2025/11/27 10:05:33 by cmetee-b          #+#    #+#             */
+/*   Updated: 2025/11/27 18:41:07 by cmetee-b         ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+#ifndef TWI_H
+#define TWI_H
+
+#include <stdint.h>
+
+/* Maître I2C piloté par l'interruption TWI (vecteur 24)
+ * Une transaction = un descripteur : écriture de wlen octets, puis
+ * (repeated START) lecture de rlen octets, puis STOP. Toute la séquence
+ * START / SLA / données / STOP est déroulée par l'ISR : le main continue
+ * pendant le transfert (~800µs pour 7 octets à 100kHz).
+ *
+ * Même maître dans Module06/ex02, au style de ce dossier (anglais,
+ * tabulations), sans le mode esclave.
+ * i2c_init() règle le débit et active le TWI avant le premier twi_submit.
+ * Timeouts : timer_millis/timer_micros de timer.c (Timer0, 1ms).
+ * Ne pas appeler les fonctions bloquantes (i2c_start...) pendant une
+ * transaction.
+ */
+
+/* ---- Débit du bus ----
+ * SCL = F_CPU / (16 + 2 × TWBR × 4^TWPS)   (21.5.2 Bit Rate Generator)
+ * TWI_BITRATE(hz) : réglage {TWPS << 8 | TWBR} calculé par le
+ * préprocesseur, plus petit prescaler qui fait tenir TWBR sur 8 bits
+ * TWBR >= 10 conseillé en maître, et SCL <= 400kHz (Table 28-13)
+ */
+#define TWI_TWBR_PS(hz, ps) ((F_CPU / (hz) - 16) / (2UL * (ps)))
+#define TWI_TWPS(hz) \
+    (TWI_TWBR_PS(hz, 1) <= 255 ? 0 : TWI_TWBR_PS(hz, 4) <= 255 ? 1 : \
+     TWI_TWBR_PS(hz, 16) <= 255 ? 2 : 3)
+#define TWI_TWBR(hz)        TWI_TWBR_PS(hz, 1UL << (2 * TWI_TWPS(hz)))
+#define TWI_BITRATE(hz)     ((uint16_t)((TWI_TWPS(hz) << 8) | TWI_TWBR(hz)))
+
+#define TWI_100K            TWI_BITRATE(100000UL)
+#define TWI_400K            TWI_BITRATE(400000UL)
+
+/* Débit au démarrage (i2c_init), -DTWI_FREQ=400000 pour le mode rapide */
+#ifndef TWI_FREQ
+# define TWI_FREQ           100000UL
+#endif
+
+#if TWI_FREQ > 400000UL
+# error "TWI_FREQ : 400kHz maximum sur l'ATmega328P"
+#endif
+#if F_CPU / TWI_FREQ < 16 + 2 * 10
+# error "TWI_FREQ trop élevé pour F_CPU (TWBR < 10)"
+#endif
+#if TWI_TWBR_PS(TWI_FREQ, 64) > 255
+# error "TWI_FREQ trop bas pour F_CPU (TWBR > 255 même avec TWPS = 64)"
+#endif
+/* Erreur d'arrondi de TWBR : débit réel à moins de 5% de TWI_FREQ */
+#if F_CPU / (16 + 2 * TWI_TWBR(TWI_FREQ) * (1UL << (2 * TWI_TWPS(TWI_FREQ)))) \
+    > TWI_FREQ + TWI_FREQ / 20 \
+    || F_CPU / (16 + 2 * TWI_TWBR(TWI_FREQ) * (1UL << (2 * TWI_TWPS(TWI_FREQ)))) \
+    < TWI_FREQ - TWI_FREQ / 20
+# error "TWI_FREQ pas atteignable à 5% près avec ce F_CPU"
+#endif
+
+#define TWI_DEFAULT         TWI_BITRATE(TWI_FREQ)
+
+/* État d'une transaction (t_twi_xfer.status) */
+#define TWI_OK              0
+#define TWI_BUSY            1   // en cours
+#define TWI_ERR_NACK_ADDR   2   // personne ne répond à l'adresse
+#define TWI_ERR_NACK_DATA   3   // octet écrit refusé
+#define TWI_ERR_ARB_LOST    4   // un autre maître a pris le bus
+#define TWI_ERR_BUS         5   // START/STOP illégal (TWSR = 0x00)
+#define TWI_ERR_TIMEOUT     6   // phase pas finie à temps (bus bloqué)
+#define TWI_ERR_STATUS      7   // TWSR inattendu pour la phase
+#define TWI_NB_STATUS       8
+
+/* Durée max d'une phase (START, un octet, STOP) : un octet prend 90µs à
+ * 100kHz, le reste laisse de la marge au clock stretching du capteur.
+ * Au-delà, le bus est considéré bloqué : TWI coupé puis twi_recover()
+ */
+#ifndef TWI_PHASE_TIMEOUT_US
+# define TWI_PHASE_TIMEOUT_US 2000
+#endif
+
+/* Statistiques, gardées à travers un reset à chaud (section .noinit,
+ * validées par magic) : remises à 0 seulement à la mise sous tension
+ * count[TWI_OK]   : transactions twi_submit réussies
+ * count[TWI_ERR_*]: erreurs, transactions et appels bloquants i2c_*
+ */
+#define TWI_STATS_MAGIC     0x7C12
+
+typedef struct s_twi_stats
+{
+    uint16_t magic;
+    uint16_t count[TWI_NB_STATUS];
+    uint16_t recoveries;        // séquences de déblocage lancées
+    uint16_t stuck;             // SDA toujours bas après déblocage
+} t_twi_stats;
+
+typedef struct s_twi_xfer t_twi_xfer;
+
+/* Appelée depuis l'ISR à la fin de la transaction (succès ou erreur) :
+ * courte, pas d'UART bloquant
+ */
+typedef void (*t_twi_cb)(t_twi_xfer *xfer);
+
+struct s_twi_xfer
+{
+    uint8_t          addr;      // adresse 7 bits
+    const uint8_t   *wbuf;
+    uint8_t          wlen;      // 0 : lecture seule
+    uint8_t         *rbuf;
+    uint8_t          rlen;      // 0 : écriture seule (wlen = rlen = 0 : sonde)
+    t_twi_cb         callback;  // 0 : pas de rappel, surveiller status
+    volatile uint8_t status;    // TWI_BUSY puis TWI_OK ou TWI_ERR_*
+    uint8_t          twsr;      // dernier TWSR lu (diagnostic)
+    uint16_t         us;        // durée, de twi_submit au STOP (µs)
+};
+
+/* Lance la transaction, retourne 0 si le bus est déjà occupé par une autre
+ * Le descripteur et les buffers doivent rester valides jusqu'à la fin
+ */
+uint8_t twi_submit(t_twi_xfer *xfer);
+
+/* 1 tant qu'une transaction est en cours */
+uint8_t twi_busy(void);
+
+/* Comme twi_busy, et termine la transaction en TWI_ERR_TIMEOUT (avec
+ * déblocage du bus) si une phase dépasse TWI_PHASE_TIMEOUT_US
+ * À appeler dans la boucle qui surveille xfer->status
+ */
+uint8_t twi_poll(void);
+
+/* Attend la fin de la transaction en mode veille IDLE (le CPU dort,
+ * l'UART et les timers continuent), retourne son status
+ */
+uint8_t twi_wait(t_twi_xfer *xfer);
+
+/* Pour les pilotes bloquants (i2c_*) : attend TWINT au plus
+ * TWI_PHASE_TIMEOUT_US, retourne TWI_OK ou TWI_ERR_TIMEOUT (bus débloqué)
+ */
+uint8_t twi_wait_twint(void);
+
+/* Change le débit (TWI_100K, TWI_400K, TWI_BITRATE(hz)) entre deux
+ * transactions ; pas d'effet si une transaction est en cours (retour 0)
+ */
+uint8_t  twi_set_bitrate(uint16_t setting);
+
+/* Débit actuel du bus en Hz, d'après TWBR/TWPS */
+uint32_t twi_bitrate_hz(void);
+
+/* ---- Mode esclave ----
+ * En plus du maître : le TWI répond à l'adresse addr, et un autre maître
+ * lit une carte de registres de size octets (au plus TWI_SLAVE_SIZE) :
+ *     écriture [reg]               : choisit le registre
+ *     lecture  [v0][v1]...          : reg, reg + 1, ... (auto-incrément,
+ *                                     0xFF au-delà de la carte)
+ * ou écriture [reg] + repeated START + lecture. Le n° de registre reste
+ * valable d'une transaction à l'autre. Chaque lecture voit une copie de
+ * la carte prise à son SLA+R (valeurs jamais à moitié mises à jour).
+ * Si les deux maîtres prennent le bus en même temps, twi_submit finit en
+ * TWI_ERR_ARB_LOST : à relancer.
+ */
+#ifndef TWI_SLAVE_SIZE
+# define TWI_SLAVE_SIZE 32
+#endif
+
+void     twi_slave_init(uint8_t addr, uint8_t size);
+
+/* Valeur 16 bits (poids fort d'abord) aux registres reg et reg + 1 */
+void     twi_slave_set(uint8_t reg, uint16_t value);
+
+/* Lectures de la carte par un maître extérieur depuis le démarrage */
+uint16_t twi_slave_reads(void);
+
+/* Code d'erreur TWI_ERR_* correspondant à un TWSR inattendu */
+uint8_t twi_error(uint8_t twsr);
+
+/* Débloque un esclave qui tient SDA à 0 (transfert coupé en plein
+ * octet) : TWI coupé, jusqu'à 9 impulsions sur SCL jusqu'à ce que SDA
+ * remonte, puis un STOP à la main. Retourne 1 si le bus est libre
+ */
+uint8_t twi_recover(void);
+
+/* Compte un status (TWI_OK ou TWI_ERR_*) dans les statistiques */
+void    twi_record(uint8_t status);
+
+/* Reprend les statistiques d'avant le reset, ou les met à 0 */
+void    twi_stats_init(void);
+const t_twi_stats *twi_stats(void);
+
+#endif
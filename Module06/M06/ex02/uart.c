@@ -12,6 +12,16 @@
 
 #include "main.h"
 
+/* Buffer circulaire d'émission
+ * tx_head : écrit par le programme principal (producteur)
+ * tx_tail : avancé par l'ISR USART_UDRE (consommateur)
+ * Buffer vide quand head == tail, plein quand head + 1 == tail
+ */
+static volatile char    tx_buf[UART_TX_SIZE];
+static volatile uint8_t tx_head = 0;
+static volatile uint8_t tx_tail = 0;
+static volatile uint16_t tx_overflows = 0;
+static volatile uint8_t tx_started = 0;     // au moins un octet envoyé
 
 void uart_init(void)
 {
@@ -21,18 +31,127 @@ void uart_init(void)
     UBRR0L = (uint8_t)(ubrr);
     
     UCSR0A = (1 << U2X0);
-    UCSR0B = (1 << TXEN0);
+    UCSR0B = (1 << TXEN0) | (1 << RXEN0);
     UCSR0C = (1 << UCSZ01) | (1 << UCSZ00);
 }
 
+/* Réception scrutée (pas d'interruption) : suffit pour un terminal tapé
+ * à la main, UDR0 garde 2 octets le temps que la boucle repasse (1ms)
+ */
+uint8_t uart_rx_ready(void)
+{
+    return (UCSR0A & (1 << RXC0)) != 0;
+}
+
+char uart_rx(void)
+{
+    while (!(UCSR0A & (1 << RXC0)))
+        ;
+    return UDR0;
+}
+
+
+/* Envoie l'octet le plus ancien du buffer (appelé avec UDR0 vide) */
+static void uart_tx_next(void)
+{
+    /* TXC0 est effacé en écrivant 1 (20.11.2) : uart_flush s'en sert.
+     * Écriture directe (pas de |=) : FE0/DOR0/UPE0 doivent être écrits à 0
+     */
+    UCSR0A = (1 << U2X0) | (1 << TXC0);
+    UDR0 = tx_buf[tx_tail];
+    tx_tail = (tx_tail + 1) & UART_TX_MASK;
+    tx_started = 1;
+}
+
+/* Vecteur 19 - USART_UDRE (Table 12-6 Reset and Interrupt Vectors)
+ * Appelé tant que UDR0 est vide et UDRIE0 actif : on envoie l'octet
+ * suivant, puis on coupe l'interruption quand le buffer est vide
+ * (sinon l'ISR serait rappelée en boucle, 20.11.3 Bit 5 – UDRIEn)
+ */
+ISR(USART_UDRE_vect)
+{
+    if (tx_head == tx_tail)
+        UCSR0B &= ~(1 << UDRIE0);
+    else
+        uart_tx_next();
+}
+
+/* Ajoute un octet dans le buffer, retourne 0 si l'octet est perdu */
+static uint8_t uart_tx_push(char c)
+{
+    uint8_t next = (tx_head + 1) & UART_TX_MASK;
+
+    while (next == tx_tail)
+    {
+#if UART_TX_POLICY == UART_TX_DROP
+        tx_overflows++;
+        return 0;
+#elif UART_TX_POLICY == UART_TX_OVERWRITE
+        /* tx_tail appartient à l'ISR : section critique (SREG sauvegardé) */
+        uint8_t sreg = SREG;
+        cli();
+        if (next == tx_tail)
+        {
+            tx_tail = (tx_tail + 1) & UART_TX_MASK;
+            tx_overflows++;
+        }
+        SREG = sreg;
+#else
+        /* Interruptions coupées : l'ISR ne videra jamais le buffer,
+         * on envoie donc nous-mêmes l'octet le plus ancien (polling)
+         */
+        if (!(SREG & (1 << SREG_I)) && (UCSR0A & (1 << UDRE0)))
+            uart_tx_next();
+#endif
+    }
+    tx_buf[tx_head] = c;
+    tx_head = next;
+
+    /* (Re)lance l'ISR : elle se déclenche dès que UDR0 est vide */
+    UCSR0B |= (1 << UDRIE0);
+    return 1;
+}
 
 void uart_tx(char c)
 {
+    uart_tx_push(c);
+}
 
-    while (!(UCSR0A & (1 << UDRE0)))
-        ;
+uint8_t uart_write(const char *buf, uint8_t len)
+{
+    uint8_t sent = 0;
+
+    while (sent < len)
+    {
+        if (!uart_tx_push(buf[sent]))
+            break;
+        sent++;
+    }
+    return sent;
+}
 
-    UDR0 = c;
+void uart_flush(void)
+{
+    while (tx_head != tx_tail)
+    {
+        if (!(SREG & (1 << SREG_I)) && (UCSR0A & (1 << UDRE0)))
+            uart_tx_next();
+    }
+    /* Dernier octet sorti du registre à décalage (TXC0, 20.6.3) */
+    if (tx_started)
+        while (!(UCSR0A & (1 << TXC0)))
+            ;
+}
+
+uint16_t uart_tx_overflows(void)
+{
+    uint16_t n;
+    uint8_t sreg = SREG;
+
+    cli();
+    n = tx_overflows;
+    SREG = sreg;
+    return n;
 }
 
 
@@ -84,23 +203,34 @@ void print_hex_value(char *c)
 }
 
 /*
- * Affiche un float avec précision donnée
- * 
- * Utilise dtostrf() pour convertir le float en string.
- * dtostrf est autorisé (fait partie de stdlib.h)
+ * Affiche un nombre à virgule fixe : value / 10^decimals
  * 
- * Paramètres:
- * - value: le nombre à afficher
- * - precision: nombre de décimales (1 pour 0.1, 2 pour 0.01)
+ * uart_printfixed(-512, 2) -> "-5.12", uart_printfixed(7, 1) -> "0.7"
+ * Remplace dtostrf : pas de float, juste des divisions entières sur
+ * les chiffres (decimals <= 9)
  */
-void uart_printfloat(float value, uint8_t precision)
+void uart_printfixed(int32_t value, uint8_t decimals)
 {
-    char buffer[16];
-    
-    // Convertir le float en string
-    // dtostrf(value, largeur_min, precision, buffer)
-    dtostrf(value, 1, precision, buffer);
-    
-    // Afficher le résultat
-    uart_printstr(buffer);
+    char     buffer[12];
+    uint8_t  i = 0;
+    uint32_t n = value;
+
+    if (value < 0)
+    {
+        uart_tx('-');
+        n = -(uint32_t)value;
+    }
+    // Chiffres à l'envers, au moins decimals + 1 (zéros de tête)
+    do
+    {
+        buffer[i++] = '0' + n % 10;
+        n /= 10;
+    } while (n || i <= decimals);
+
+    while (i--)
+    {
+        uart_tx(buffer[i]);
+        if (i == decimals && decimals)
+            uart_tx('.');
+    }
 }
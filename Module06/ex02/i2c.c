@@ -2,12 +2,14 @@
 #include "i2c.h"
 #include "uart.h"
 #include "i2c_debug.h"
+#include "twi.h"
 
 void	i2c_init(void)
 {
-	/* so we wan 100khz on i2c bus and we have this equation: SCLfrq = F_CPU / (16 + 2 * TWBR * prescaler) */
-	/* Hence, I set up TWBR at 72 and an prescaler of 1. which doesn't need set up because it's 2 bits cleared*/
-	TWBR = 72;
+	/* SCLfrq = F_CPU / (16 + 2 * TWBR * prescaler): TWBR and prescaler for
+	 * TWI_FREQ are computed at compile time (twi.h), 100khz by default
+	 * (TWBR = 72, prescaler 1), -DTWI_FREQ=400000UL for fast mode */
+	twi_set_bitrate(TWI_DEFAULT);
 	/* SDA is on port PC4 and SCL is ont port PC5 */
 	SET_INPUT(C, 4);
 	SET_INPUT(C, 5);
@@ -18,12 +20,46 @@ void	i2c_init(void)
 	/* Wait need in man to power up the sensor */
 	SET(TWCR, TWEA);
 	/* ACK signal will be sent : I can confirm if my data is correctly transmitted on the TWI bus*/
+	/* Error statistics survive a warm reset; a slave still holding SDA
+	 * low (reset in the middle of a read) is clocked free */
+	twi_stats_init();
+	i2c_trace_init();
+	if (!(PINC & (1 << PC4)))
+		twi_recover();
 	if (DEBUG)
 		uart_printstr("I2C has been initialized\n\r");
 }
 
-void	i2c_start(uint8_t address, uint8_t mode)
+/* Waits for the end of a bus phase and records it in the trace */
+static uint8_t	i2c_wait(uint8_t phase)
 {
+	if (twi_wait_twint() != TWI_OK)
+	{
+		i2c_trace(PH_TIMEOUT);
+		return (TWI_ERR_TIMEOUT);
+	}
+	i2c_trace(phase);
+	return (TWI_OK);
+}
+
+/* TWI_OK when TWSR is one of the two expected states, else the matching
+ * TWI_ERR_* code (counted in the statistics) */
+static uint8_t	i2c_check(uint8_t expected, uint8_t other)
+{
+	uint8_t	status = TW_STATUS;
+	uint8_t	err;
+
+	if (status == expected || status == other)
+		return (TWI_OK);
+	err = twi_error(status);
+	twi_record(err);
+	return (err);
+}
+
+uint8_t	i2c_start(uint8_t address, uint8_t mode)
+{
+	uint8_t	err;
+
 	/* MCU is the master, T Sensor is the slave. I need to send message asking for a start on the bus and with address of T Sensor */
 	/* Step one: write what I want to do */
 	SET(TWCR, TWSTA);
@@ -34,59 +70,106 @@ void	i2c_start(uint8_t address, uint8_t mode)
 
 	/* Step three: wait for the start condition to be correctly transmit */
 	/* When the TWINT flag is set (so becomes = 1), it means the start condition has been transmitted and we can read change in status */
-	while (!(TWCR & (1 << TWINT))) ;
-	if (DEBUG || ((uint8_t)(TWSR) != 0x08 && (uint8_t)(TWSR) != 0x10))
-		i2c_start_debug();
+	/* Every wait is bounded by TWI_PHASE_TIMEOUT_US: on a stuck bus we get
+	 * TWI_ERR_TIMEOUT (and the bus recovery) instead of hanging forever */
+	if (i2c_wait(PH_START) != TWI_OK)
+		return (TWI_ERR_TIMEOUT);
+	err = i2c_check(TW_START, TW_REP_START);
+	if (err != TWI_OK)
+		return (err);
 
-	i2c_address(address, mode);
+	return (i2c_address(address, mode));
 }
 
-void	i2c_stop(void)
+uint8_t	i2c_stop(void)
 {
+	uint32_t	start = timer_micros();
+
 	/* Step one: write that I will send a stop condition: */
 	SET(TWCR, TWSTO);
 
 	/* Step two: clear the TWINT to send the stop condition */
 	SET(TWCR, TWINT);
-	if (DEBUG)
-		uart_printstr("Stop condition has been transmitted\n\r");
+	/* TWSTO is cleared once the STOP is out on the bus */
+	while (TWCR & (1 << TWSTO))
+	{
+		if (timer_micros() - start >= TWI_PHASE_TIMEOUT_US)
+		{
+			twi_record(TWI_ERR_TIMEOUT);
+			twi_recover();
+			i2c_trace(PH_TIMEOUT);
+			return (TWI_ERR_TIMEOUT);
+		}
+	}
+	i2c_trace(PH_STOP);
+	return (TWI_OK);
 }
 
 
-void	i2c_write(unsigned char data)
+uint8_t	i2c_write(unsigned char data)
 {
 	TWDR = data;
 	SET(TWCR, TWEA);
 	/* uart_printstr("doing...\n\r"); */
 	SET(TWCR, TWINT);
 
-	while (!(TWCR & (1 << TWINT))) ;
-	if (DEBUG)
-		i2c_write_debug();
+	if (i2c_wait(PH_WRITE) != TWI_OK)
+		return (TWI_ERR_TIMEOUT);
+	return (i2c_check(TW_MT_DATA_ACK, TW_MT_DATA_ACK));
 }
 
-uint8_t	i2c_read(void)
+/* The byte goes to *data, ACK or NACK as set in TWEA by the caller */
+uint8_t	i2c_read(uint8_t *data)
 {
-	uint8_t res;
 	SET(TWCR, TWINT);
-	while (!(TWCR & (1 << TWINT))) ;
-	res = TWDR;
-	if (DEBUG || ((uint8_t)(TWSR) != 0x50 && (uint8_t)(TWSR) != 0x58))
-		i2c_read_debug(res);
-	return (res);
+	if (i2c_wait(PH_READ) != TWI_OK)
+		return (TWI_ERR_TIMEOUT);
+	*data = TWDR;
+	return (i2c_check(TW_MR_DATA_ACK, TW_MR_DATA_NACK));
 }
 
-void	i2c_address(uint8_t address, uint8_t mode)
+uint8_t	i2c_address(uint8_t address, uint8_t mode)
 /* If mode = 0 -> write mode, if mode = 1 -> read mode */
 {	
 	TWDR = address + mode;
 	CLEAR(TWCR, TWSTA);
 	SET(TWCR, TWINT);
 	/* Write the address plus the byte for read or write mode. Than send it on the bus */
-	while (!(TWCR & (1 << TWINT))) ;
-	if ((DEBUG || (uint8_t)(TWSR) != 0x18) && !mode)
-		i2c_write_address_debug();
-	if ((DEBUG || (uint8_t)(TWSR) != 0x40) && mode)
-		i2c_read_address_debug();
+	if (i2c_wait(mode ? PH_SLA_R : PH_SLA_W) != TWI_OK)
+		return (TWI_ERR_TIMEOUT);
+	return (i2c_check(mode ? TW_MR_SLA_ACK : TW_MT_SLA_ACK, 0xFF));
 }
 
+uint8_t	i2c_write_read(uint8_t addr, const uint8_t *wbuf, uint8_t wlen, uint8_t *rbuf, uint8_t rlen)
+{
+	uint8_t	err = TWI_OK;
+	uint8_t	stop;
+
+	/* Write phase (also a bare SLA+W probe when there is nothing to read) */
+	if (wlen || !rlen)
+	{
+		err = i2c_start(addr << 1, 0);
+		for (uint8_t i = 0; i < wlen && err == TWI_OK; i++)
+			err = i2c_write(wbuf[i]);
+	}
+	/* Read phase: after a write, i2c_start sends a repeated START, the bus
+	 * is never released between the two. ACK on every byte but the last
+	 * one, NACK tells the slave we are done */
+	if (rlen && err == TWI_OK)
+	{
+		err = i2c_start(addr << 1, 1);
+		for (uint8_t i = 0; i < rlen && err == TWI_OK; i++)
+		{
+			if (i == rlen - 1)
+				CLEAR(TWCR, TWEA);
+			else
+				SET(TWCR, TWEA);
+			err = i2c_read(&rbuf[i]);
+		}
+	}
+	/* STOP even after an error: the bus is released for the next one */
+	stop = i2c_stop();
+	if (err != TWI_OK)
+		return (err);
+	return (stop);
+}
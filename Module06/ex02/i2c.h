@@ -11,13 +11,20 @@
 # define ACK 1
 # define NACK 0
 
+/* Every call but i2c_init returns TWI_OK or a TWI_ERR_* code (twi.h),
+ * and never waits more than TWI_PHASE_TIMEOUT_US per bus phase */
 void	i2c_init(void);
-void	i2c_start(uint8_t address, uint8_t mode);
-void	i2c_stop(void);
-void	i2c_write(unsigned char data);
-uint8_t	i2c_read(void);
+uint8_t	i2c_start(uint8_t address, uint8_t mode);
+uint8_t	i2c_stop(void);
+uint8_t	i2c_write(unsigned char data);
+uint8_t	i2c_read(uint8_t *data);
 
-void	i2c_address(uint8_t address, uint8_t mode);
+uint8_t	i2c_address(uint8_t address, uint8_t mode);
+
+/* Whole transaction to the 7 bit address addr: START, wlen bytes written,
+ * repeated START, rlen bytes read (NACK on the last one), STOP.
+ * wlen = 0: read only; rlen = 0: write only */
+uint8_t	i2c_write_read(uint8_t addr, const uint8_t *wbuf, uint8_t wlen, uint8_t *rbuf, uint8_t rlen);
 
 
 #endif
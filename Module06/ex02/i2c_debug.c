@@ -1,87 +1,146 @@
+#include <avr/interrupt.h>
 #include "i2c_debug.h"
 #include "main.h"
 #include "uart.h"
 
-void	i2c_start_debug(void)
+t_trace		g_trace[I2C_TRACE_SIZE];
+uint8_t		g_trace_head = 0;
+uint16_t	g_trace_count = 0;
+
+void	i2c_trace_init(void)
+{
+	/* Timer1 normal mode, clk/64 (Table 16-5): only read by i2c_trace */
+	TCCR1A = 0;
+	TCCR1B = (1 << CS11) | (1 << CS10);
+}
+
+static void	unexpected(uint8_t twsr)
 {
-	if ((uint8_t)(TWSR) == 0x08)
+	uart_printstr("Unexpected Error Flag: TWSR = 0x");
+	print_hex_value(twsr);
+	uart_printstr("\r\n");
+}
+
+static void	start_debug(uint8_t twsr)
+{
+	if (twsr == 0x08)
 		uart_printstr("START condition has been transmitted\n\r");
-	else if ((uint8_t)(TWSR) == 0x10)
+	else if (twsr == 0x10)
 		uart_printstr("Repeated START condition has been transmitted\n\r");
 	else
-	{
-		uart_printstr("Unexcepted Error Flag: TWSR = 0x");	
-		print_hex_value((uint8_t)(TWSR));
-		uart_printstr("\r\n");
-	}
+		unexpected(twsr);
 }
 
-void	i2c_write_debug(void)
+static void	write_debug(uint8_t twsr, uint8_t twdr)
 {
-	uart_printstr("Data byte has been transmitted. ");
-	if ((uint8_t)(TWSR) == 0x28)
+	uart_printstr("Data byte 0x");
+	print_hex_value(twdr);
+	uart_printstr(" has been transmitted. ");
+	if (twsr == 0x28)
 		uart_printstr("ACK received\r\n");
-	else if ((uint8_t)(TWSR) == 0x30)
+	else if (twsr == 0x30)
 		uart_printstr("NOT ACK received\r\n");
-	else if ((uint8_t)(TWSR) == 0x38)
+	else if (twsr == 0x38)
 		uart_printstr("Arbitration lost in data byte.\r\n");
 	else
-	{
-		uart_printstr("Unexcepted Error Flag: TWSR = 0x");
-		print_hex_value((uint8_t)(TWSR));
-		uart_printstr("\r\n");	
-	}
+		unexpected(twsr);
 }
 
-void	i2c_read_debug(uint8_t transmit)
-{	
-	if ((uint8_t)(TWSR) == 0x50 || (uint8_t)(TWSR) == 0x58)
-	{	
+static void	read_debug(uint8_t twsr, uint8_t twdr)
+{
+	if (twsr == 0x50 || twsr == 0x58)
+	{
 		uart_printstr("Value of read byte is: 0x");
-		print_hex_value(transmit);
-		if ((uint8_t)(TWSR) == 0x50)
+		print_hex_value(twdr);
+		if (twsr == 0x50)
 			uart_printstr(" . ACK returned\r\n");
 		else
 			uart_printstr(" . NOT ACK returned\r\n");
 	}
 	else
-	{
-		uart_printstr("Unexpected Error Flag: TWSR = 0x");
-		print_hex_value((uint8_t)(TWSR));
-		uart_printstr("\r\n");
-	}
+		unexpected(twsr);
 }
 
-void	i2c_write_address_debug(void)
+static void	write_address_debug(uint8_t twsr)
 {
 	uart_printstr("SLA+W has been transmitted. ");
-	if ((uint8_t)(TWSR) == 0x18)
+	if (twsr == 0x18)
 		uart_printstr("ACK received\r\n");
-	else if ((uint8_t)(TWSR) == 0x20)
+	else if (twsr == 0x20)
 		uart_printstr("NOT ACK received\r\n");
-	else if ((uint8_t)(TWSR) == 0x38)
+	else if (twsr == 0x38)
 		uart_printstr("Arbitration lost in SLA+W\r\n");
 	else
-	{
-		uart_printstr("Unexcepted Error Flag: TWSR = 0x");
-		print_hex_value((uint8_t)(TWSR));
-		uart_printstr("\r\n");
-	}	
+		unexpected(twsr);
 }
 
-void	i2c_read_address_debug(void)
+static void	read_address_debug(uint8_t twsr)
 {
 	uart_printstr("SLA+R has been transmitted. ");
-	if ((uint8_t)(TWSR) == 0x40)
+	if (twsr == 0x40)
 		uart_printstr("ACK received\r\n");
-	else if ((uint8_t)(TWSR) == 0x48)
+	else if (twsr == 0x48)
 		uart_printstr("NOT ACK received\r\n");
-	else if ((uint8_t)(TWSR) == 0x10)
+	else if (twsr == 0x38)
 		uart_printstr("Arbitration lost in SLA+R.\r\n");
+	else
+		unexpected(twsr);
+}
+
+static void	trace_print(const t_trace *t)
+{
+	if (t->phase == PH_START)
+		start_debug(t->twsr);
+	else if (t->phase == PH_SLA_W)
+		write_address_debug(t->twsr);
+	else if (t->phase == PH_SLA_R)
+		read_address_debug(t->twsr);
+	else if (t->phase == PH_WRITE)
+		write_debug(t->twsr, t->twdr);
+	else if (t->phase == PH_READ)
+		read_debug(t->twsr, t->twdr);
+	else if (t->phase == PH_STOP)
+		uart_printstr("Stop condition has been transmitted\n\r");
 	else
 	{
-		uart_printstr("Unexcepted Error Flag: TWSR = 0x");
-		print_hex_value((uint8_t)(TWSR));
+		uart_printstr("Timeout, bus recovered. TWSR = 0x");
+		print_hex_value(t->twsr);
 		uart_printstr("\r\n");
 	}
 }
+
+void	i2c_trace_dump(void)
+{
+	uint8_t		n;
+	uint8_t		i;
+	uint16_t	count;
+	uint16_t	prev;
+	uint8_t		sreg;
+
+	/* Copy of the indexes first, interrupts off: the TWI ISR also writes
+	 * the ring. Called between transactions, nothing moves while we print */
+	sreg = SREG;
+	cli();
+	count = g_trace_count;
+	i = g_trace_head;
+	g_trace_count = 0;
+	SREG = sreg;
+	n = (count > I2C_TRACE_SIZE) ? I2C_TRACE_SIZE : count;
+	if (count > I2C_TRACE_SIZE)
+	{
+		uart_printdeca(count - I2C_TRACE_SIZE);
+		uart_printstr(" older events lost\r\n");
+	}
+	i = (i - n) & I2C_TRACE_MASK;
+	prev = g_trace[i].time;
+	while (n--)
+	{
+		/* Time since the previous event (16 bits: wraps cleanly) */
+		uart_printstr("+");
+		uart_printdeca((uint16_t)(g_trace[i].time - prev) * (uint32_t)I2C_TRACE_US_PER_TICK);
+		uart_printstr("us ");
+		trace_print(&g_trace[i]);
+		prev = g_trace[i].time;
+		i = (i + 1) & I2C_TRACE_MASK;
+	}
+}
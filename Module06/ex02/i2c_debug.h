@@ -4,10 +4,55 @@
 # include <avr/io.h>
 # include <util/twi.h>
 
-void	i2c_start_debug(void);
-void	i2c_write_debug(void);
-void	i2c_read_debug(uint8_t transmit);
-void	i2c_write_address_debug(void);
-void	i2c_read_address_debug(void);
+/* Trace of the bus events: each I2C step (blocking i2c_* call or TWI
+ * ISR step of a twi_submit transaction) stores {time, TWSR, TWDR, phase}
+ * in a ring (a few cycles, no UART), i2c_trace_dump() decodes it to text
+ * later, once the transaction is over: printing at 115200 bauds in the
+ * middle of a transfer took milliseconds per event and changed the timing
+ * we were trying to look at.
+ * Time: Timer1 free running at clk/64, 4us per tick (wraps every 262ms) */
+# ifndef I2C_TRACE_SIZE
+#  define I2C_TRACE_SIZE 32
+# endif
+# define I2C_TRACE_MASK (I2C_TRACE_SIZE - 1)
+# define I2C_TRACE_US_PER_TICK 4
+
+# define PH_START 0
+# define PH_SLA_W 1
+# define PH_SLA_R 2
+# define PH_WRITE 3
+# define PH_READ 4
+# define PH_STOP 5
+# define PH_TIMEOUT 6
+
+typedef struct s_trace
+{
+	uint16_t	time;
+	uint8_t		twsr;
+	uint8_t		twdr;
+	uint8_t		phase;
+}	t_trace;
+
+extern t_trace	g_trace[I2C_TRACE_SIZE];
+extern uint8_t	g_trace_head;
+extern uint16_t	g_trace_count;
+
+/* Inline: a dozen cycles, the oldest entry is overwritten when full */
+static inline void	i2c_trace(uint8_t phase)
+{
+	t_trace	*t = &g_trace[g_trace_head];
+
+	t->time = TCNT1;
+	t->twsr = TW_STATUS;
+	t->twdr = TWDR;
+	t->phase = phase;
+	g_trace_head = (g_trace_head + 1) & I2C_TRACE_MASK;
+	g_trace_count++;
+}
+
+void	i2c_trace_init(void);
+
+/* Prints the recorded events (oldest first) and empties the ring */
+void	i2c_trace_dump(void);
 
 #endif
@@ -1,103 +1,166 @@
 #include "main.h"
 #include "i2c.h"
 #include "uart.h"
+#include "twi.h"
+#include "i2c_debug.h"
+#include "stats.h"
 
 
-void	print_data(uint32_t rh[3], uint32_t temp[3], uint8_t rotation, uint8_t begin)
-{
-	uint16_t	tmp;
-
-	tmp = 0;
-	uart_printstr("temperature: ");
-	temp[rotation] = (temp[rotation] / 5242.88f) - 50;
-	for (int i = 0; i < begin; i++)
-		tmp += (temp[i]);
-	tmp /= begin;
-	uart_printdeca(tmp);
-	uart_printstr(" .C\r\n");
+/* Last measures in hundredths: mean, min and max over the window
+ * without keeping the float conversion of every slot (stats.c) */
+STATS(g_temp, MEASURE_WINDOW);
+STATS(g_rh, MEASURE_WINDOW);
 
-	tmp = 0;
-	uart_printstr("humidity: ");
-	rh[rotation] = (rh[rotation] / 10485.76f);
-	for (int i = 0; i < begin; i++)
-		tmp += (rh[i]);
-	tmp /= begin;
-	uart_printdeca(tmp);
-	uart_printstr(" %\n\r");
+static void	print_centi(int16_t value)
+{
+	if (value < 0)
+	{
+		uart_tx('-');
+		value = -value;
+	}
+	uart_printdeca(value / 100);
+	uart_tx('.');
+	uart_tx('0' + (value % 100) / 10);
+	uart_tx('0' + value % 10);
 }
 
-void	read_value(uint32_t *rh, uint32_t *temp)
+static void	print_line(const char *name, const t_stats *stats, const char *unit)
 {
-	uint16_t 	buff[3];
+	uart_printstr(name);
+	print_centi(stats_mean(stats));
+	uart_printstr(unit);
+	uart_printstr(" (min ");
+	print_centi(stats_min(stats));
+	uart_printstr(", max ");
+	print_centi(stats_max(stats));
+	uart_printstr(")\r\n");
+}
 
-	buff[0] = i2c_read();
-	buff[1] = i2c_read();
-	buff[2] = i2c_read();
-	*rh = ((uint32_t)buff[0] << 12) | ((uint32_t)buff[1] << 4) | (buff[2] >> 4);
+void	print_data(uint32_t rh, uint32_t temp)
+{
+	/* T = raw * 200 / 2^20 - 50 and RH = raw * 100 / 2^20, rounded to the
+	 * hundredth: raw * 625 < 2^30, no float and no overflow */
+	stats_update(&g_temp, (int16_t)((temp * 625 + (1UL << 14)) >> 15) - 5000);
+	stats_update(&g_rh, (int16_t)((rh * 625 + (1UL << 15)) >> 16));
+	print_line("temperature: ", &g_temp, " .C");
+	print_line("humidity: ", &g_rh, " %");
+}
 
-	buff[0] = buff[2];
-	buff[1] = i2c_read();
-	CLEAR(TWCR, TWEA);
-	buff[2] = i2c_read();
-	*temp = ((uint32_t)(buff[0] & 0x0F) << 16) | ((uint32_t)buff[1] << 8) | buff[2];
+/* Frame bytes 1 to 5: 20 bits of humidity then 20 bits of temperature */
+void	read_value(const uint8_t *frame, uint32_t *rh, uint32_t *temp)
+{
+	*rh = ((uint32_t)frame[1] << 12) | ((uint32_t)frame[2] << 4) | (frame[3] >> 4);
+	*temp = ((uint32_t)(frame[3] & 0x0F) << 16) | ((uint32_t)frame[4] << 8) | frame[5];
 }
 
 uint8_t	check_init(void)
 {
-	uint8_t	buff;
+	uint8_t	status = 0;
 
-	i2c_start(TEMP_SENSOR_ADDRESS << 1, 1);
-	CLEAR(TWCR, TWEA);
-	buff = i2c_read();
-	i2c_stop();
-	if (!(buff >> 3) & 0x01)
+	if (i2c_write_read(TEMP_SENSOR_ADDRESS, 0, 0, &status, 1) != TWI_OK
+		|| !((status >> 3) & 0x01))
 		return (1);
 	return (0);
 }
 
 void	init_sensor(void)
 {
-	i2c_start(TEMP_SENSOR_ADDRESS << 1, 0);
-	i2c_write(0xBE);
-	i2c_write(0x08);
-	i2c_write(0x00);
-	i2c_stop();
+	static const uint8_t	init[3] = {0xBE, 0x08, 0x00};
+
+	i2c_write_read(TEMP_SENSOR_ADDRESS, init, 3, 0, 0);
 	_delay_ms(10);
 }
 
+/* A failed step costs one reading, not the whole device */
+void	print_error(const char *step, uint8_t err)
+{
+	const t_twi_stats	*stats = twi_stats();
+
+	uart_printstr(step);
+	uart_printstr(" failed, error ");
+	uart_printdeca(err);
+	uart_printstr(" (timeouts ");
+	uart_printdeca(stats->count[TWI_ERR_TIMEOUT]);
+	uart_printstr(", nack ");
+	uart_printdeca(stats->count[TWI_ERR_NACK_ADDR] + stats->count[TWI_ERR_NACK_DATA]);
+	uart_printstr(", recoveries ");
+	uart_printdeca(stats->recoveries);
+	uart_printstr(")\r\n");
+	/* What happened on the bus, decoded now that it is over */
+	i2c_trace_dump();
+}
+
 int	main(void)
 {
-	uint32_t	temp[3] = {0, 0, 0};
-	uint32_t	rh[3] = {0, 0, 0};
-	uint8_t		rotation = 0;
-	uint8_t		begin = 1;
+	static const uint8_t	trigger[3] = {0xAC, 0x33, 0x00};
+	t_twi_xfer				measure = {TEMP_SENSOR_ADDRESS, trigger, 3, 0, 0, 0, 0, 0, 0};
+	uint32_t				temp;
+	uint32_t				rh;
+	uint8_t					triggered = 0;
+	uint32_t				start = 0;
+	uint32_t				since = 0;
+	uint16_t				wait = 0;
+	uint8_t					frame[6];
+	uint8_t					err;
 
 	init_uart(F_CPU / (8 * 115200) - 1);
 	i2c_init();
+	timer_init();
+	/* TWI ISR drives the trigger command, Timer0 counts milliseconds */
+	sei();
 	_delay_ms(40);
 	if (check_init())
 		init_sensor();
+	set_sleep_mode(SLEEP_MODE_IDLE);
+	/* No delay in the loop: each step only starts once its wait is over,
+	 * the CPU sleeps until the next interrupt (1ms at most) in between
+	 */
 	while (1) 
 	{
-		uart_printstr("\r\n");
-		i2c_start(TEMP_SENSOR_ADDRESS << 1, 0);
-		i2c_write(0xAC);
-		i2c_write(0x33);
-		i2c_write(0x00);
-		i2c_stop();
-		_delay_ms(80);
-		while (1)
+		if (twi_poll() || timer_millis() - since < wait)
+		{
+			sleep_mode();
+			continue ;
+		}
+		since = timer_millis();
+		if (!triggered)
+		{
+			uart_printstr("\r\n");
+			twi_submit(&measure);
+			triggered = 1;
+			start = since;
+			wait = MEASURE_MS;
+			continue ;
+		}
+		triggered = 0;
+		if (measure.status != TWI_OK)
+		{
+			print_error("trigger", measure.status);
+			wait = MEASURE_PERIOD_MS;
+			continue ;
+		}
+		/* Status byte and data in one read: busy bit still set, the data
+		 * is not there yet and we come back BUSY_POLL_MS later */
+		err = i2c_write_read(TEMP_SENSOR_ADDRESS, 0, 0, frame, 6);
+		if (err == TWI_OK && ((frame[0] >> 7) & 0x01))
+		{
+			triggered = 1;
+			wait = BUSY_POLL_MS;
+			continue ;
+		}
+		if (err != TWI_OK)
 		{
-			i2c_start(TEMP_SENSOR_ADDRESS << 1, 1);
-			if (!((i2c_read() >> 7) & 0x01))
-				break ;
-			_delay_ms(80);
+			print_error("read", err);
+			since = start;
+			wait = MEASURE_PERIOD_MS;
+			continue ;
 		}
-		read_value(&rh[rotation], &temp[rotation]);
-		print_data(rh, temp, rotation, begin);
-		rotation = (rotation + 1) % 3;
-		_delay_ms(2000);
-		if (begin < 3)
-			begin++;
+		read_value(frame, &rh, &temp);
+		print_data(rh, temp);
+		if (DEBUG)
+			i2c_trace_dump();
+		/* Next trigger MEASURE_PERIOD_MS after this one */
+		since = start;
+		wait = MEASURE_PERIOD_MS;
 	}
 }
@@ -21,5 +21,16 @@
 # include <avr/io.h>
 # include <util/twi.h>
 # include <util/delay.h>
+# include <avr/interrupt.h>
+# include <avr/sleep.h>
+
+# define MEASURE_PERIOD_MS 2000
+# define MEASURE_MS 80
+# define BUSY_POLL_MS 10
+# define MEASURE_WINDOW 3	/* measures averaged, at most 64 (stats.h) */
+
+void		timer_init(void);
+uint32_t	timer_millis(void);
+uint32_t	timer_micros(void);
 
 #endif
@@ -0,0 +1,131 @@
+#include "stats.h"
+
+void	stats_reset(t_stats *s)
+{
+	s->sum = 0;
+	s->sumsq = 0;
+	s->pos = 0;
+	s->n = 0;
+	s->min_head = 0;
+	s->min_len = 0;
+	s->max_head = 0;
+	s->max_len = 0;
+}
+
+uint8_t	stats_set_window(t_stats *s, uint8_t window)
+{
+	if (window == 0 || window > s->size)
+		return (0);
+	s->window = window;
+	stats_reset(s);
+	return (1);
+}
+
+/* Next index in a circular window of window slots (no modulo) */
+static uint8_t	stats_next(const t_stats *s, uint8_t i)
+{
+	if (i + 1 == s->window)
+		return (0);
+	return (i + 1);
+}
+
+/* Position of slot i after the head of a queue */
+static uint8_t	stats_at(const t_stats *s, uint8_t head, uint8_t i)
+{
+	i += head;
+	if (i >= s->window)
+		return (i - s->window);
+	return (i);
+}
+
+/* Monotonic queue: the positions x makes useless (they leave the window
+ * before x and can never be the min/max again) are removed from the back,
+ * then the position of x is added. Each position enters and leaves once.
+ * less = 1 for the min (increasing values), 0 for the max */
+static void	stats_push(t_stats *s, uint8_t *q, uint8_t head, uint8_t *len,
+	int16_t x, uint8_t less)
+{
+	int16_t	back;
+
+	while (*len)
+	{
+		back = s->buf[q[stats_at(s, head, *len - 1)]];
+		if (less ? back < x : back > x)
+			break ;
+		(*len)--;
+	}
+	q[stats_at(s, head, *len)] = s->pos;
+	(*len)++;
+}
+
+void	stats_update(t_stats *s, int16_t x)
+{
+	int16_t	old;
+
+	/* Full window: buf[pos] is the oldest sample, it leaves. If it heads
+	 * a queue it leaves it too (anywhere else it is already gone) */
+	if (s->n == s->window)
+	{
+		old = s->buf[s->pos];
+		s->sum -= old;
+		s->sumsq -= (uint32_t)((int32_t)old * old);
+		if (s->min_len && s->qmin[s->min_head] == s->pos)
+		{
+			s->min_head = stats_next(s, s->min_head);
+			s->min_len--;
+		}
+		if (s->max_len && s->qmax[s->max_head] == s->pos)
+		{
+			s->max_head = stats_next(s, s->max_head);
+			s->max_len--;
+		}
+	}
+	else
+		s->n++;
+	/* Queues updated before the write: they compare with buf */
+	stats_push(s, s->qmin, s->min_head, &s->min_len, x, 1);
+	stats_push(s, s->qmax, s->max_head, &s->max_len, x, 0);
+	s->buf[s->pos] = x;
+	s->sum += x;
+	s->sumsq += (uint32_t)((int32_t)x * x);
+	s->pos = stats_next(s, s->pos);
+}
+
+int16_t	stats_min(const t_stats *s)
+{
+	if (!s->min_len)
+		return (0);
+	return (s->buf[s->qmin[s->min_head]]);
+}
+
+int16_t	stats_max(const t_stats *s)
+{
+	if (!s->max_len)
+		return (0);
+	return (s->buf[s->qmax[s->max_head]]);
+}
+
+int16_t	stats_mean(const t_stats *s)
+{
+	if (!s->n)
+		return (0);
+	/* Rounded to the nearest, negative sums included */
+	if (s->sum < 0)
+		return ((s->sum - s->n / 2) / s->n);
+	return ((s->sum + s->n / 2) / s->n);
+}
+
+uint32_t	stats_variance(const t_stats *s)
+{
+	uint64_t	var;
+
+	if (!s->n)
+		return (0);
+	/* var = (N * sum(x^2) - sum(x)^2) / N^2, exact in integers (>= 0 by
+	 * construction) */
+	var = s->sumsq * s->n - (uint64_t)((int64_t)s->sum * s->sum);
+	var /= (uint16_t)s->n * s->n;
+	if (var > 0xFFFFFFFF)
+		return (0xFFFFFFFF);
+	return ((uint32_t)var);
+}
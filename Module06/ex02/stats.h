@@ -0,0 +1,63 @@
+#ifndef STATS_H
+# define STATS_H
+
+# include <stdint.h>
+
+/* Rolling statistics over the last N samples (N <= 64): min, max, mean
+ * and variance in O(1) per sample, no float.
+ * - sum and sum of squares kept up to date (the oldest sample leaves,
+ *   the new one comes in)
+ * - min and max from monotonic queues: a position enters and leaves
+ *   them once, the window is never scanned again
+ * Buffer size is fixed at compile time, the window in use can be made
+ * smaller later (stats_set_window).
+ * Module06/M06/ex02 has the same code (French comments, 4 spaces) */
+# define STATS_MAX_WINDOW 64
+
+typedef struct s_stats
+{
+	int16_t		*buf;
+	uint8_t		*qmin;
+	uint8_t		*qmax;
+	int32_t		sum;
+	uint64_t	sumsq;
+	uint8_t		size;
+	uint8_t		window;
+	uint8_t		pos;
+	uint8_t		n;
+	uint8_t		min_head;
+	uint8_t		min_len;
+	uint8_t		max_head;
+	uint8_t		max_len;
+}	t_stats;
+/* buf: last samples (circular window). qmin/qmax: positions in buf,
+ * values increasing/decreasing. sumsq on 64 bits: 64 * 32768^2 does not
+ * fit in 32. size: buffers, window <= size. n: samples received, up to
+ * window */
+
+/* Buffers declared with the accumulator, window = size at first:
+ *     STATS(g_temp, 16);    16 last samples, 64 bytes */
+# define STATS(name, size) \
+	static int16_t name##_buf[(size)]; \
+	static uint8_t name##_qmin[(size)]; \
+	static uint8_t name##_qmax[(size)]; \
+	static t_stats name = {name##_buf, name##_qmin, name##_qmax, \
+		0, 0, (size), (size), 0, 0, 0, 0, 0, 0}
+
+/* Empties the window (min/max/mean start again from the next sample) */
+void		stats_reset(t_stats *s);
+
+/* New window (1..size), 0 when out of range. Empties the window */
+uint8_t		stats_set_window(t_stats *s, uint8_t window);
+
+/* Adds x, and drops the oldest sample when the window is full */
+void		stats_update(t_stats *s, int16_t x);
+
+/* Results over the samples present (0 if none). Mean rounded, population
+ * variance in unit^2 */
+int16_t		stats_min(const t_stats *s);
+int16_t		stats_max(const t_stats *s);
+int16_t		stats_mean(const t_stats *s);
+uint32_t	stats_variance(const t_stats *s);
+
+#endif
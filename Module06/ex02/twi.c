@@ -0,0 +1,355 @@
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include <avr/sleep.h>
+#include <util/twi.h>
+#include <util/delay.h>
+#include "main.h"
+#include "twi.h"
+#include "i2c_debug.h"
+
+/* Bus pins (PC4 = SDA, PC5 = SCL), used as GPIO by twi_recover: output
+ * low, or input (released, pulled up) */
+#define TWI_SDA PC4
+#define TWI_SCL PC5
+#define TWI_HALF_US 5 /* SCL half period of the recovery (100khz) */
+
+/* TWCR for each action (21.9.2), TWIE always set during a transaction:
+ * the ISR runs every time TWINT goes up */
+#define TWCR_START ((1 << TWINT) | (1 << TWSTA) | (1 << TWEN) | (1 << TWIE))
+#define TWCR_NEXT ((1 << TWINT) | (1 << TWEN) | (1 << TWIE))
+#define TWCR_ACK ((1 << TWINT) | (1 << TWEA) | (1 << TWEN) | (1 << TWIE))
+#define TWCR_STOP ((1 << TWINT) | (1 << TWSTO) | (1 << TWEN))
+#define TWCR_FREE ((1 << TWINT) | (1 << TWEN))
+
+static t_twi_xfer *volatile	current = 0;
+static uint8_t				widx;
+static uint8_t				ridx;
+static volatile uint32_t	phase_us;
+static uint32_t				start_us;
+
+static t_twi_stats	g_stats __attribute__((section(".noinit")));
+
+static void	twi_finish(uint8_t status, uint8_t twcr)
+{
+	t_twi_xfer	*xfer = current;
+
+	/* STOP (or bus released) and TWIE cleared: no more interrupts */
+	TWCR = twcr;
+	if (twcr == TWCR_STOP)
+		i2c_trace(PH_STOP);
+	current = 0;
+	xfer->us = timer_micros() - start_us;
+	twi_record(status);
+	xfer->status = status;
+	if (xfer->callback)
+		xfer->callback(xfer);
+}
+
+/* After SLA+R, ACK or NACK prepared for the next byte: NACK right away
+ * when only one byte is expected (Table 21-4) */
+static uint8_t	twi_read_ack(void)
+{
+	if (ridx + 1 < current->rlen)
+		return (TWCR_ACK);
+	return (TWCR_NEXT);
+}
+
+/* Trace phase of a status, for i2c_trace_dump (arbitration lost and bus
+ * error are decoded by the write and START lines) */
+static uint8_t	twi_phase(uint8_t status)
+{
+	switch (status)
+	{
+		case TW_MT_SLA_ACK:
+		case TW_MT_SLA_NACK:
+			return (PH_SLA_W);
+		case TW_MR_SLA_ACK:
+		case TW_MR_SLA_NACK:
+			return (PH_SLA_R);
+		case TW_MT_DATA_ACK:
+		case TW_MT_DATA_NACK:
+		case TW_MT_ARB_LOST:
+			return (PH_WRITE);
+		case TW_MR_DATA_ACK:
+		case TW_MR_DATA_NACK:
+			return (PH_READ);
+		default:
+			return (PH_START);
+	}
+}
+
+/* Vector 24 - TWI: one step of the transaction per interrupt.
+ * Status codes: Table 21-3 (transmitter) and 21-4 (receiver) */
+ISR(TWI_vect)
+{
+	t_twi_xfer	*xfer = current;
+	uint8_t		status = TW_STATUS;
+
+	/* Before TWCR is written: TWSR and TWDR still hold this step */
+	i2c_trace(twi_phase(status));
+	if (!xfer)
+	{
+		/* Master step of a transaction already over (timeout): the bus is
+		 * still ours, release it with a STOP. Lost arbitration: it belongs
+		 * to the other master, just step back */
+		if (status == TW_MT_ARB_LOST || status == TW_NO_INFO)
+			TWCR = TWCR_FREE;
+		else
+		{
+			TWCR = TWCR_STOP;
+			i2c_trace(PH_STOP);
+		}
+		return ;
+	}
+	xfer->twsr = status;
+	phase_us = timer_micros();
+	switch (status)
+	{
+		case TW_START:
+		case TW_REP_START:
+			/* Write first (or probe), read after the repeated START */
+			if (widx < xfer->wlen || xfer->rlen == 0)
+				TWDR = (xfer->addr << 1) | TW_WRITE;
+			else
+				TWDR = (xfer->addr << 1) | TW_READ;
+			TWCR = TWCR_NEXT;
+			break ;
+		case TW_MT_SLA_ACK:
+		case TW_MT_DATA_ACK:
+			if (widx < xfer->wlen)
+			{
+				TWDR = xfer->wbuf[widx++];
+				TWCR = TWCR_NEXT;
+			}
+			else if (xfer->rlen)
+				TWCR = TWCR_START;
+			else
+				twi_finish(TWI_OK, TWCR_STOP);
+			break ;
+		case TW_MR_SLA_ACK:
+			TWCR = twi_read_ack();
+			break ;
+		case TW_MR_DATA_ACK:
+			xfer->rbuf[ridx++] = TWDR;
+			TWCR = twi_read_ack();
+			break ;
+		case TW_MR_DATA_NACK:
+			/* Last byte (NACK sent by us) */
+			xfer->rbuf[ridx++] = TWDR;
+			twi_finish(TWI_OK, TWCR_STOP);
+			break ;
+		case TW_MT_SLA_NACK:
+		case TW_MR_SLA_NACK:
+			twi_finish(TWI_ERR_NACK_ADDR, TWCR_STOP);
+			break ;
+		case TW_MT_DATA_NACK:
+			twi_finish(TWI_ERR_NACK_DATA, TWCR_STOP);
+			break ;
+		case TW_MT_ARB_LOST:
+			/* Bus released without STOP: it belongs to the other master */
+			twi_finish(TWI_ERR_ARB_LOST, TWCR_FREE);
+			break ;
+		default:
+			/* TW_BUS_ERROR: internal STOP, the TWI releases the lines */
+			twi_finish(twi_error(status), TWCR_STOP);
+			break ;
+	}
+}
+
+uint8_t	twi_submit(t_twi_xfer *xfer)
+{
+	uint8_t	sreg = SREG;
+
+	if (current)
+		return (0);
+	/* Previous STOP not out on the bus yet (a few us) */
+	phase_us = timer_micros();
+	while (TWCR & (1 << TWSTO))
+	{
+		if (timer_micros() - phase_us >= TWI_PHASE_TIMEOUT_US)
+		{
+			twi_recover();
+			break ;
+		}
+	}
+	/* Last check and START with interrupts off: the transaction is
+	 * published and started in one go */
+	cli();
+	if (current)
+	{
+		SREG = sreg;
+		return (0);
+	}
+	widx = 0;
+	ridx = 0;
+	xfer->status = TWI_BUSY;
+	xfer->twsr = TW_NO_INFO;
+	phase_us = timer_micros();
+	start_us = phase_us;
+	current = xfer;
+	TWCR = TWCR_START;
+	SREG = sreg;
+	return (1);
+}
+
+uint8_t	twi_busy(void)
+{
+	return (current != 0);
+}
+
+uint8_t	twi_poll(void)
+{
+	uint8_t	sreg = SREG;
+
+	if (!current)
+		return (0);
+	if (timer_micros() - phase_us < TWI_PHASE_TIMEOUT_US)
+		return (1);
+	/* Phase too long: the ISR will not run any more, finish in its place
+	 * (critical section: it could still come in the meantime) */
+	cli();
+	if (current && timer_micros() - phase_us >= TWI_PHASE_TIMEOUT_US)
+	{
+		current->twsr = TW_STATUS;
+		i2c_trace(PH_TIMEOUT);
+		twi_recover();
+		twi_finish(TWI_ERR_TIMEOUT, TWCR_FREE);
+	}
+	SREG = sreg;
+	return (current != 0);
+}
+
+uint8_t	twi_wait(t_twi_xfer *xfer)
+{
+	uint8_t	sreg = SREG;
+
+	/* Timer0 wakes the CPU up every millisecond: the timeout is checked
+	 * even if the TWI interrupt never comes */
+	set_sleep_mode(SLEEP_MODE_IDLE);
+	while (1)
+	{
+		twi_poll();
+		cli();
+		if (xfer->status != TWI_BUSY)
+			break ;
+		/* sei() then sleep_cpu(): no wake up lost between the test and
+		 * going to sleep */
+		sleep_enable();
+		sei();
+		sleep_cpu();
+		sleep_disable();
+	}
+	SREG = sreg;
+	return (xfer->status);
+}
+
+uint8_t	twi_wait_twint(void)
+{
+	uint32_t	start = timer_micros();
+
+	while (!(TWCR & (1 << TWINT)))
+	{
+		if (timer_micros() - start >= TWI_PHASE_TIMEOUT_US)
+		{
+			twi_record(TWI_ERR_TIMEOUT);
+			twi_recover();
+			return (TWI_ERR_TIMEOUT);
+		}
+	}
+	return (TWI_OK);
+}
+
+uint8_t	twi_set_bitrate(uint16_t setting)
+{
+	if (current)
+		return (0);
+	TWBR = setting & 0xFF;
+	/* TWPS1:0 are the only writable bits of TWSR (21.9.3) */
+	TWSR = (setting >> 8) & 0x03;
+	return (1);
+}
+
+uint32_t	twi_bitrate_hz(void)
+{
+	uint8_t	ps = TWSR & 0x03;
+
+	return (F_CPU / (16 + 2UL * TWBR * (1 << (2 * ps))));
+}
+
+uint8_t	twi_error(uint8_t twsr)
+{
+	switch (twsr & TW_STATUS_MASK)
+	{
+		case TW_MT_SLA_NACK:
+		case TW_MR_SLA_NACK:
+			return (TWI_ERR_NACK_ADDR);
+		case TW_MT_DATA_NACK:
+			return (TWI_ERR_NACK_DATA);
+		case TW_MT_ARB_LOST:
+			return (TWI_ERR_ARB_LOST);
+		case TW_BUS_ERROR:
+			return (TWI_ERR_BUS);
+		default:
+			return (TWI_ERR_STATUS);
+	}
+}
+
+uint8_t	twi_recover(void)
+{
+	uint8_t	twbr = TWBR;
+	uint8_t	free;
+
+	g_stats.recoveries++;
+	/* TWI disabled: PC4/PC5 are GPIO again. PORT low: as an output the
+	 * line is pulled low, as an input it is released (open drain) */
+	TWCR = 0;
+	PORTC &= ~((1 << TWI_SDA) | (1 << TWI_SCL));
+	DDRC &= ~((1 << TWI_SDA) | (1 << TWI_SCL));
+	_delay_us(TWI_HALF_US);
+	/* The slave finishes the byte it thinks is going on: at most 9 clocks
+	 * (8 bits + ACK) before it releases SDA */
+	for (uint8_t i = 0; i < 9 && !(PINC & (1 << TWI_SDA)); i++)
+	{
+		DDRC |= (1 << TWI_SCL);
+		_delay_us(TWI_HALF_US);
+		DDRC &= ~(1 << TWI_SCL);
+		_delay_us(TWI_HALF_US);
+	}
+	/* STOP: SDA goes up while SCL is high */
+	DDRC |= (1 << TWI_SCL);
+	_delay_us(TWI_HALF_US);
+	DDRC |= (1 << TWI_SDA);
+	_delay_us(TWI_HALF_US);
+	DDRC &= ~(1 << TWI_SCL);
+	_delay_us(TWI_HALF_US);
+	DDRC &= ~(1 << TWI_SDA);
+	_delay_us(TWI_HALF_US);
+	free = (PINC & (1 << TWI_SDA)) && (PINC & (1 << TWI_SCL));
+	if (!free)
+		g_stats.stuck++;
+	TWBR = twbr;
+	TWCR = (1 << TWEN);
+	return (free);
+}
+
+void	twi_record(uint8_t status)
+{
+	if (status < TWI_NB_STATUS)
+		g_stats.count[status]++;
+}
+
+void	twi_stats_init(void)
+{
+	if (g_stats.magic == TWI_STATS_MAGIC)
+		return ;
+	for (uint8_t i = 0; i < TWI_NB_STATUS; i++)
+		g_stats.count[i] = 0;
+	g_stats.recoveries = 0;
+	g_stats.stuck = 0;
+	g_stats.magic = TWI_STATS_MAGIC;
+}
+
+const t_twi_stats	*twi_stats(void)
+{
+	return (&g_stats);
+}
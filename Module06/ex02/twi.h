@@ -0,0 +1,151 @@
+#ifndef TWI_H
+# define TWI_H
+
+# include <stdint.h>
+
+/* I2C master driven by the TWI interrupt (vector 24).
+ * One transaction = one descriptor: wlen bytes written, then (repeated
+ * START) rlen bytes read, then STOP. The ISR runs the whole START / SLA /
+ * data / STOP sequence, main keeps going during the transfer (~800us for
+ * 7 bytes at 100khz).
+ * Module06/M06/ex02 has the same master (French comments, 4 spaces) and
+ * a slave mode on top of it.
+ * i2c_init() sets the bit rate and enables the TWI before the first
+ * twi_submit. Timeouts use timer_millis/timer_micros (timer.c, Timer0).
+ * Do not call the blocking i2c_* functions during a transaction */
+
+/* Bus speed: SCL = F_CPU / (16 + 2 * TWBR * 4^TWPS) (21.5.2)
+ * TWI_BITRATE(hz) is the {TWPS << 8 | TWBR} setting computed by the
+ * preprocessor, with the smallest prescaler that keeps TWBR on 8 bits.
+ * TWBR >= 10 as a master and SCL <= 400khz (Table 28-13) */
+# define TWI_TWBR_PS(hz, ps) ((F_CPU / (hz) - 16) / (2UL * (ps)))
+# define TWI_TWPS(hz) \
+	(TWI_TWBR_PS(hz, 1) <= 255 ? 0 : TWI_TWBR_PS(hz, 4) <= 255 ? 1 : \
+	TWI_TWBR_PS(hz, 16) <= 255 ? 2 : 3)
+# define TWI_TWBR(hz) TWI_TWBR_PS(hz, 1UL << (2 * TWI_TWPS(hz)))
+# define TWI_BITRATE(hz) ((uint16_t)((TWI_TWPS(hz) << 8) | TWI_TWBR(hz)))
+
+# define TWI_100K TWI_BITRATE(100000UL)
+# define TWI_400K TWI_BITRATE(400000UL)
+
+/* Speed at startup (i2c_init), -DTWI_FREQ=400000UL for fast mode */
+# ifndef TWI_FREQ
+#  define TWI_FREQ 100000UL
+# endif
+
+# if TWI_FREQ > 400000UL
+#  error "TWI_FREQ: 400khz at most on the ATmega328P"
+# endif
+# if F_CPU / TWI_FREQ < 16 + 2 * 10
+#  error "TWI_FREQ too high for F_CPU (TWBR < 10)"
+# endif
+# if TWI_TWBR_PS(TWI_FREQ, 64) > 255
+#  error "TWI_FREQ too low for F_CPU (TWBR > 255 even with TWPS = 64)"
+# endif
+/* TWBR rounding: the real speed must stay within 5% of TWI_FREQ */
+# if F_CPU / (16 + 2 * TWI_TWBR(TWI_FREQ) * (1UL << (2 * TWI_TWPS(TWI_FREQ)))) \
+	> TWI_FREQ + TWI_FREQ / 20 \
+	|| F_CPU / (16 + 2 * TWI_TWBR(TWI_FREQ) * (1UL << (2 * TWI_TWPS(TWI_FREQ)))) \
+	< TWI_FREQ - TWI_FREQ / 20
+#  error "TWI_FREQ not reachable within 5% with this F_CPU"
+# endif
+
+# define TWI_DEFAULT TWI_BITRATE(TWI_FREQ)
+
+/* Transaction state (t_twi_xfer.status) */
+# define TWI_OK 0
+# define TWI_BUSY 1 /* in progress */
+# define TWI_ERR_NACK_ADDR 2 /* nobody answers the address */
+# define TWI_ERR_NACK_DATA 3 /* written byte refused */
+# define TWI_ERR_ARB_LOST 4 /* another master took the bus */
+# define TWI_ERR_BUS 5 /* illegal START/STOP (TWSR = 0x00) */
+# define TWI_ERR_TIMEOUT 6 /* phase not over in time (stuck bus) */
+# define TWI_ERR_STATUS 7 /* unexpected TWSR for the phase */
+# define TWI_NB_STATUS 8
+
+/* Longest bus phase (START, one byte, STOP): a byte takes 90us at 100khz,
+ * the rest is margin for the sensor's clock stretching. Past it the bus
+ * is stuck: TWI disabled then twi_recover() */
+# ifndef TWI_PHASE_TIMEOUT_US
+#  define TWI_PHASE_TIMEOUT_US 2000
+# endif
+
+/* Statistics kept across a warm reset (.noinit section, checked with a
+ * magic number): only cleared at power on.
+ * count[TWI_OK]: successful twi_submit transactions
+ * count[TWI_ERR_*]: errors, from transactions and blocking i2c_* calls */
+# define TWI_STATS_MAGIC 0x7C12
+
+typedef struct s_twi_stats
+{
+	uint16_t	magic;
+	uint16_t	count[TWI_NB_STATUS];
+	uint16_t	recoveries;
+	uint16_t	stuck;
+}	t_twi_stats;
+
+typedef struct s_twi_xfer	t_twi_xfer;
+
+/* Called from the ISR when the transaction ends (success or error):
+ * keep it short, no blocking UART */
+typedef void	(*t_twi_cb)(t_twi_xfer *xfer);
+
+struct s_twi_xfer
+{
+	uint8_t				addr;
+	const uint8_t		*wbuf;
+	uint8_t				wlen;
+	uint8_t				*rbuf;
+	uint8_t				rlen;
+	t_twi_cb			callback;
+	volatile uint8_t	status;
+	uint8_t				twsr;
+	uint16_t			us;
+};
+/* addr: 7 bit address. wlen = 0: read only, rlen = 0: write only (both 0:
+ * probe). callback = 0: watch status instead. status: TWI_BUSY then
+ * TWI_OK or TWI_ERR_*. twsr: last TWSR read. us: twi_submit to STOP */
+
+/* Starts the transaction, 0 if the bus is already taken by another one.
+ * The descriptor and the buffers must stay valid until it ends */
+uint8_t		twi_submit(t_twi_xfer *xfer);
+
+/* 1 while a transaction is in progress */
+uint8_t		twi_busy(void);
+
+/* Same as twi_busy, and ends the transaction with TWI_ERR_TIMEOUT (bus
+ * recovered) when a phase takes more than TWI_PHASE_TIMEOUT_US.
+ * Call it in the loop that watches xfer->status */
+uint8_t		twi_poll(void);
+
+/* Waits for the end of the transaction in IDLE sleep (CPU stopped, UART
+ * and timers running), returns its status */
+uint8_t		twi_wait(t_twi_xfer *xfer);
+
+/* For the blocking drivers (i2c_*): waits for TWINT at most
+ * TWI_PHASE_TIMEOUT_US, returns TWI_OK or TWI_ERR_TIMEOUT (bus recovered) */
+uint8_t		twi_wait_twint(void);
+
+/* Changes the bus speed (TWI_100K, TWI_400K, TWI_BITRATE(hz)) between two
+ * transactions, no effect (returns 0) while one is in progress */
+uint8_t		twi_set_bitrate(uint16_t setting);
+
+/* Current bus speed in hz, from TWBR/TWPS */
+uint32_t	twi_bitrate_hz(void);
+
+/* TWI_ERR_* code matching an unexpected TWSR */
+uint8_t		twi_error(uint8_t twsr);
+
+/* Frees a slave holding SDA low (transfer cut in the middle of a byte):
+ * TWI disabled, up to 9 pulses on SCL until SDA goes up, then a STOP by
+ * hand. Returns 1 when the bus is free */
+uint8_t		twi_recover(void);
+
+/* Counts a status (TWI_OK or TWI_ERR_*) in the statistics */
+void		twi_record(uint8_t status);
+
+/* Keeps the statistics from before the reset, or clears them */
+void		twi_stats_init(void);
+const t_twi_stats	*twi_stats(void);
+
+#endif
@@ -16,6 +16,9 @@ int main(void)
 {
     char buffer[128];
     uart_init();
+
+    /* Active les interruptions : l'ISR USART_UDRE vide le buffer d'émission */
+    sei();
     
     for (volatile uint32_t i = 0; i < 100000; i++);
     
@@ -15,6 +15,7 @@
 
 #include <avr/io.h>
 #include <avr/eeprom.h>
+#include <avr/interrupt.h>
 
 #define F_CPU 16000000UL
 
@@ -31,14 +32,66 @@
 // Taille max des chaînes
 #define MAX_STRING_LEN 32
 
+/* Buffer circulaire d'émission (vidé par l'interruption USART_UDRE)
+ * UART_TX_SIZE doit être une puissance de 2 (index masqué, pas de modulo)
+ */
+#ifndef UART_TX_SIZE
+#define UART_TX_SIZE 64
+#endif
+#define UART_TX_MASK (UART_TX_SIZE - 1)
+/* Index uint8_t masqués : puissance de 2, 256 au plus */
+#if (UART_TX_SIZE & UART_TX_MASK) || UART_TX_SIZE > 256
+# error "UART_TX_SIZE doit être une puissance de 2 <= 256"
+#endif
+
+/* Politique quand le buffer est plein (-DUART_TX_POLICY=... dans CFLAGS)
+ * BLOCK     : attend qu'une place se libère (aucune perte)
+ * DROP      : jette le nouvel octet
+ * OVERWRITE : écrase l'octet le plus ancien encore en attente
+ */
+#define UART_TX_BLOCK      0
+#define UART_TX_DROP       1
+#define UART_TX_OVERWRITE  2
+#ifndef UART_TX_POLICY
+#define UART_TX_POLICY UART_TX_BLOCK
+#endif
+
+/* Buffer circulaire de réception (rempli par l'interruption USART_RX) */
+#ifndef UART_RX_SIZE
+#define UART_RX_SIZE 64
+#endif
+#define UART_RX_MASK (UART_RX_SIZE - 1)
+/* Index uint8_t masqués : puissance de 2, 256 au plus */
+#if (UART_RX_SIZE & UART_RX_MASK) || UART_RX_SIZE > 256
+# error "UART_RX_SIZE doit être une puissance de 2 <= 256"
+#endif
+
+/* Assemblage des lignes directement dans l'ISR (-DUART_RX_LINES=1)
+ * L'ISR gère backspace et Entrée, le main récupère des lignes complètes
+ * avec uart_getline(). Sans cette option, uart_rx() lit le buffer octet
+ * par octet.
+ */
+#ifndef UART_RX_LINES
+#define UART_RX_LINES 0
+#endif
+#define UART_LINE_SLOTS 2
+#define UART_LINE_SIZE 128
+
 /* UART */
 void uart_init(void);
 void uart_tx(char c);
+uint8_t uart_write(const char *buf, uint8_t len);
+void uart_flush(void);
+uint16_t uart_tx_overflows(void);
 void uart_printstr(const char *str);
 void uart_printhex(uint8_t value);
 void uart_printhex_lower(uint8_t value);
 void uart_println(const char *str);
 char uart_rx(void);
+uint8_t uart_rx_available(void);
+uint8_t uart_getline(char *buffer, uint8_t max_len);
+uint16_t uart_rx_overruns(void);
+uint16_t uart_rx_hw_overruns(void);
 
 /* Commandes */
 void cmd_read(const char *key);
@@ -12,6 +12,36 @@
 
 #include "main.h"
 
+/* Buffer circulaire d'émission
+ * tx_head : écrit par le programme principal (producteur)
+ * tx_tail : avancé par l'ISR USART_UDRE (consommateur)
+ * Buffer vide quand head == tail, plein quand head + 1 == tail
+ */
+static volatile char    tx_buf[UART_TX_SIZE];
+static volatile uint8_t tx_head = 0;
+static volatile uint8_t tx_tail = 0;
+static volatile uint16_t tx_overflows = 0;
+static volatile uint8_t tx_started = 0;     // au moins un octet envoyé
+
+/* Réception : l'ISR USART_RX écrit (rx_head), le main lit (rx_tail)
+ * rx_overruns    : octets/lignes perdus car le buffer logiciel était plein
+ * rx_hw_overruns : flag DOR0, octet écrasé dans UDR0 avant lecture
+ */
+#if UART_RX_LINES
+static volatile char    line_buf[UART_LINE_SLOTS][UART_LINE_SIZE];
+static volatile uint8_t line_len = 0;       // taille de la ligne en cours
+static volatile uint8_t line_fill = 0;      // slot rempli par l'ISR
+static volatile uint8_t line_read = 0;      // slot lu par le main
+static volatile uint8_t line_count = 0;     // lignes complètes en attente
+static volatile uint8_t line_drop = 0;      // ligne perdue, ignorée jusqu'à sa fin
+#else
+static volatile char    rx_buf[UART_RX_SIZE];
+static volatile uint8_t rx_head = 0;
+static volatile uint8_t rx_tail = 0;
+#endif
+static volatile uint16_t rx_overruns = 0;
+static volatile uint16_t rx_hw_overruns = 0;
+
 void uart_init(void)
 {
     /* Calcul du baudrate en mode U2X pour meilleure précision
@@ -38,6 +68,9 @@ void uart_init(void)
      * bit 4 – RXEN0: Receiver Enable
      */
     UCSR0B = (1 << TXEN0) | (1 << RXEN0);
+
+    /* Interruption de réception (20.11.3 Bit 7 – RXCIEn) */
+    UCSR0B |= (1 << RXCIE0);
     
     /* Configuration du format: 8 bits, 1 stop bit, pas de parité (p.186-187)
      * UCSZ01:UCSZ00 = 11 pour 8 bits de données (Table 20-11 p.203)
@@ -45,21 +78,267 @@ void uart_init(void)
     UCSR0C = (1 << UCSZ01) | (1 << UCSZ00);
 }
 
+/* Envoie l'octet le plus ancien du buffer (appelé avec UDR0 vide) */
+static void uart_tx_next(void)
+{
+    /* TXC0 est effacé en écrivant 1 (20.11.2) : uart_flush s'en sert.
+     * Écriture directe (pas de |=) : FE0/DOR0/UPE0 doivent être écrits à 0
+     */
+    UCSR0A = (1 << U2X0) | (1 << TXC0);
+    UDR0 = tx_buf[tx_tail];
+    tx_tail = (tx_tail + 1) & UART_TX_MASK;
+    tx_started = 1;
+}
+
+/* Vecteur 19 - USART_UDRE (Table 12-6 Reset and Interrupt Vectors)
+ * Appelé tant que UDR0 est vide et UDRIE0 actif : on envoie l'octet
+ * suivant, puis on coupe l'interruption quand le buffer est vide
+ * (sinon l'ISR serait rappelée en boucle, 20.11.3 Bit 5 – UDRIEn)
+ */
+ISR(USART_UDRE_vect)
+{
+    if (tx_head == tx_tail)
+        UCSR0B &= ~(1 << UDRIE0);
+    else
+        uart_tx_next();
+}
+
+/* Ajoute un octet dans le buffer, retourne 0 si l'octet est perdu */
+static uint8_t uart_tx_push(char c)
+{
+    uint8_t next = (tx_head + 1) & UART_TX_MASK;
+
+    while (next == tx_tail)
+    {
+#if UART_TX_POLICY == UART_TX_DROP
+        tx_overflows++;
+        return 0;
+#elif UART_TX_POLICY == UART_TX_OVERWRITE
+        /* tx_tail appartient à l'ISR : section critique (SREG sauvegardé) */
+        uint8_t sreg = SREG;
+        cli();
+        if (next == tx_tail)
+        {
+            tx_tail = (tx_tail + 1) & UART_TX_MASK;
+            tx_overflows++;
+        }
+        SREG = sreg;
+#else
+        /* Interruptions coupées : l'ISR ne videra jamais le buffer,
+         * on envoie donc nous-mêmes l'octet le plus ancien (polling)
+         */
+        if (!(SREG & (1 << SREG_I)) && (UCSR0A & (1 << UDRE0)))
+            uart_tx_next();
+#endif
+    }
+    tx_buf[tx_head] = c;
+    tx_head = next;
+
+    /* (Re)lance l'ISR : elle se déclenche dès que UDR0 est vide */
+    UCSR0B |= (1 << UDRIE0);
+    return 1;
+}
+
 void uart_tx(char c)
 {
-    while (!(UCSR0A & (1 << UDRE0)))
-        ;
-    UDR0 = c;
+    uart_tx_push(c);
+}
+
+uint8_t uart_write(const char *buf, uint8_t len)
+{
+    uint8_t sent = 0;
+
+    while (sent < len)
+    {
+        if (!uart_tx_push(buf[sent]))
+            break;
+        sent++;
+    }
+    return sent;
+}
+
+void uart_flush(void)
+{
+    while (tx_head != tx_tail)
+    {
+        if (!(SREG & (1 << SREG_I)) && (UCSR0A & (1 << UDRE0)))
+            uart_tx_next();
+    }
+    /* Dernier octet sorti du registre à décalage (TXC0, 20.6.3) */
+    if (tx_started)
+        while (!(UCSR0A & (1 << TXC0)))
+            ;
+}
+
+uint16_t uart_tx_overflows(void)
+{
+    uint16_t n;
+    uint8_t sreg = SREG;
+
+    cli();
+    n = tx_overflows;
+    SREG = sreg;
+    return n;
 }
 
-/* Réception d'un caractère 
- * Bit 7 – RXCn: USART Receive Complete
+#if UART_RX_LINES
+/* Assemblage d'une ligne (appelé depuis l'ISR uniquement)
+ * Les deux slots pleins : line_fill est revenu sur line_read, que le
+ * main n'a pas encore lu. La ligne qui arrive est alors jetée en entier
+ * (une perte comptée dans rx_overruns) au lieu d'écraser la plus ancienne
  */
+static void uart_line_feed(char c)
+{
+    volatile char *line = line_buf[line_fill];
+
+    if (c == '\r' || c == '\n')
+    {
+        if (line_drop)
+        {
+            line_drop = 0;
+            return;
+        }
+        /* "\r\n" envoyé par certains terminaux : pas de ligne vide en plus */
+        if (line_len == 0 && c == '\n')
+            return;
+        if (line_count == UART_LINE_SLOTS)
+        {
+            rx_overruns++;
+            return;
+        }
+        line[line_len] = '\0';
+        line_len = 0;
+        line_fill = (line_fill + 1) % UART_LINE_SLOTS;
+        line_count++;
+        return;
+    }
+    if (line_drop)
+        return;
+    if (c == 0x7F || c == 0x08)
+    {
+        if (line_len > 0)
+            line_len--;
+        return;
+    }
+    /* Début d'une ligne sans slot libre (line_len est alors forcément 0 :
+     * line_count n'augmente qu'en fin de ligne)
+     */
+    if (line_count == UART_LINE_SLOTS)
+    {
+        rx_overruns++;
+        line_drop = 1;
+        return;
+    }
+    if (line_len < UART_LINE_SIZE - 1)
+        line[line_len++] = c;
+}
+#endif
+
+/* Vecteur 18 - USART_RX (Table 12-6 Reset and Interrupt Vectors)
+ * Un octet est arrivé : on le range tout de suite, même si le main
+ * est occupé (écriture EEPROM ~3.3ms par octet)
+ */
+ISR(USART_RX_vect)
+{
+    /* Lire UCSR0A avant UDR0 : les flags d'erreur suivent le
+     * buffer de réception (20.7.4 Receiver Error Flags)
+     */
+    uint8_t status = UCSR0A;
+    char c = UDR0;
+
+    if (status & (1 << DOR0))
+        rx_hw_overruns++;
+#if UART_RX_LINES
+    uart_line_feed(c);
+#else
+    uint8_t next = (rx_head + 1) & UART_RX_MASK;
+
+    if (next == rx_tail)
+    {
+        rx_overruns++;
+        return;
+    }
+    rx_buf[rx_head] = c;
+    rx_head = next;
+#endif
+}
+
+#if !UART_RX_LINES
+/* Réception d'un caractère depuis le buffer (attend s'il est vide) */
 char uart_rx(void)
 {
-    while (!(UCSR0A & (1 << RXC0)))
+    char c;
+
+    while (rx_head == rx_tail)
         ;
-    return UDR0;
+    c = rx_buf[rx_tail];
+    rx_tail = (rx_tail + 1) & UART_RX_MASK;
+    return c;
+}
+#endif
+
+/* Nombre d'octets en attente (mode ligne : lignes complètes ou en cours) */
+uint8_t uart_rx_available(void)
+{
+#if UART_RX_LINES
+    return line_count + (line_len != 0);
+#else
+    return (rx_head - rx_tail) & UART_RX_MASK;
+#endif
+}
+
+/* Copie la prochaine ligne complète dans buffer
+ * Retourne 1 si une ligne a été copiée, 0 sinon (non bloquant)
+ * Sans UART_RX_LINES, toujours 0 : utiliser uart_rx()
+ */
+uint8_t uart_getline(char *buffer, uint8_t max_len)
+{
+#if UART_RX_LINES
+    uint8_t i = 0;
+    uint8_t sreg;
+
+    if (line_count == 0)
+        return 0;
+    /* Le slot line_read n'est plus touché par l'ISR tant que line_count > 0 */
+    while (i < max_len - 1 && line_buf[line_read][i])
+    {
+        buffer[i] = line_buf[line_read][i];
+        i++;
+    }
+    buffer[i] = '\0';
+    line_read = (line_read + 1) % UART_LINE_SLOTS;
+    sreg = SREG;
+    cli();
+    line_count--;
+    SREG = sreg;
+    return 1;
+#else
+    (void)buffer;
+    (void)max_len;
+    return 0;
+#endif
+}
+
+uint16_t uart_rx_overruns(void)
+{
+    uint16_t n;
+    uint8_t sreg = SREG;
+
+    cli();
+    n = rx_overruns;
+    SREG = sreg;
+    return n;
+}
+
+uint16_t uart_rx_hw_overruns(void)
+{
+    uint16_t n;
+    uint8_t sreg = SREG;
+
+    cli();
+    n = rx_hw_overruns;
+    SREG = sreg;
+    return n;
 }
 
 
@@ -109,6 +109,16 @@ void cmd_print(void)
 
 
 // Lecture d'une ligne avec backspace
+#if UART_RX_LINES
+// Ligne déjà assemblée par l'ISR : on attend qu'elle soit complète puis
+// on l'affiche d'un bloc (pas d'écho caractère par caractère dans ce mode)
+void read_line(char *buffer, uint8_t max_len)
+{
+	while (!uart_getline(buffer, max_len))
+		;
+	uart_println(buffer);
+}
+#else
 void read_line(char *buffer, uint8_t max_len)
 {
 	uint8_t buf_idx = 0;
@@ -143,6 +153,7 @@ void read_line(char *buffer, uint8_t max_len)
 		}
 	}
 }
+#endif
 
 // Parser la commande
 void parse_command(const char *buffer, char *cmd) {
@@ -36,6 +36,9 @@ uint8_t read_ADC_value(void) {
   SET_BIT(ADCSRA, ADSC);
   // Wait for the end of the conversion
   while ((ADCSRA & (1 << ADIF)) == 0) {}
+  // ADIF is only cleared by writing 1 to it (24.9.2): without this every
+  // following read returned at once, before its conversion was done
+  SET_BIT(ADCSRA, ADIF);
   return ADCH;
 }
 
@@ -15,10 +15,20 @@
 # define REV_BIT(REGISTER, BIT) REGISTER ^= (1 << BIT)
 
 
+// Gauge thresholds (8-bit ADC: 33%, 66%, 100%) and hysteresis band
+# define GAUGE_BAND 3
+// Counters are printed every REPORT_EVERY samples
+# define REPORT_EVERY 10000
+
 uint8_t read_ADC_value(void);
 void ADC_init_potentiometre(void);
 
 void spi_master_init();
 void set_leds(uint32_t d6, uint32_t d7, uint32_t d8);
 
+void uart_init(void);
+void uart_tx(char c);
+void uart_printstr(const char *str);
+void uart_printnbr(uint32_t n);
+
 #endif
@@ -0,0 +1,36 @@
+#include "gauge.h"
+
+void gauge_init(t_gauge *g, const uint8_t *thr, uint8_t count, uint8_t band,
+                void (*render)(uint8_t level)) {
+  g->thr = thr;
+  g->count = count;
+  g->band = band;
+  g->level = 0;
+  g->shown = 0;
+  g->render = render;
+  g->samples = 0;
+  g->frames = 0;
+}
+
+
+uint8_t gauge_update(t_gauge *g, uint8_t value) {
+  uint8_t level = g->level;
+
+  g->samples++;
+  // Going up: threshold reached
+  while (level < g->count && value >= g->thr[level]) {
+    level++;
+  }
+  // Going down: must drop below the threshold minus the band
+  while (level > 0 && (uint16_t)value + g->band < g->thr[level - 1]) {
+    level--;
+  }
+  if (g->shown && level == g->level) {
+    return 0;
+  }
+  g->level = level;
+  g->shown = 1;
+  g->render(level);
+  g->frames++;
+  return 1;
+}
@@ -0,0 +1,29 @@
+#ifndef GAUGE_H
+# define GAUGE_H
+
+#include <stdint.h>
+
+// Event-driven gauge: every sample is quantized into a level with
+// hysteresis, and the render callback (one SPI frame) only runs when the
+// level changes. A still potentiometer sends nothing on the bus.
+//
+// Level goes up when value >= thr[level]
+// Level goes down when value < thr[level - 1] - band
+typedef struct s_gauge {
+  const uint8_t *thr;      // increasing thresholds
+  uint8_t count;           // number of thresholds: levels 0..count
+  uint8_t band;            // hysteresis width
+  uint8_t level;
+  uint8_t shown;           // 0 until the first frame
+  void (*render)(uint8_t level);
+  uint32_t samples;        // samples fed in
+  uint32_t frames;         // frames actually sent
+} t_gauge;
+
+void gauge_init(t_gauge *g, const uint8_t *thr, uint8_t count, uint8_t band,
+                void (*render)(uint8_t level));
+
+// Feed one sample, returns 1 if a frame was sent
+uint8_t gauge_update(t_gauge *g, uint8_t value);
+
+#endif
@@ -1,4 +1,5 @@
 #include "exo.h"
+#include "gauge.h"
 #include <avr/io.h>
 #include <util/delay.h>
 
@@ -7,12 +8,16 @@ void init_pins(void) {
 }
 
 
-void digital_gauge(uint8_t adc_value) {
-  if (adc_value == 0xff) {
+static const uint8_t g_thresholds[] = {0xff * 33 / 100, 0xff * 66 / 100, 0xff};
+
+
+// One APA102 frame per call: only called by the gauge on a level change
+void digital_gauge(uint8_t level) {
+  if (level == 3) {
     set_leds(0xff0000, 0xff0000, 0xff0000);
-  } else if (adc_value >= 0xff * 66 / 100) {
+  } else if (level == 2) {
     set_leds(0xff0000, 0xff0000, 0x00);
-  } else if (adc_value >= 0xff * 33 / 100) {
+  } else if (level == 1) {
     set_leds(0xff0000, 0x00, 0x00);
   } else {
     set_leds(0x00, 0x00, 0x00);
@@ -21,16 +26,23 @@ void digital_gauge(uint8_t adc_value) {
 
 
 int main() {
+  t_gauge gauge;
+
   init_pins();
   spi_master_init();
   ADC_init_potentiometre();
-  set_leds(0x00, 0x00, 0x00);
-  uint8_t old_value = 0;
+  uart_init();
+  gauge_init(&gauge, g_thresholds, sizeof(g_thresholds), GAUGE_BAND,
+             digital_gauge);
   while (1) {
-    uint8_t adc_value = read_ADC_value();
-    if (adc_value != old_value) {
-      digital_gauge(adc_value);
-      old_value = adc_value;
+    gauge_update(&gauge, read_ADC_value());
+    // SPI traffic check: frames sent vs samples taken
+    if (gauge.samples % REPORT_EVERY == 0) {
+      uart_printstr("samples ");
+      uart_printnbr(gauge.samples);
+      uart_printstr(", frames ");
+      uart_printnbr(gauge.frames);
+      uart_printstr("\r\n");
     }
   }
 }
@@ -0,0 +1,40 @@
+#include "exo.h"
+#include <avr/io.h>
+
+// Minimal polled TX, only used to report the gauge counters
+void uart_init(void) {
+  unsigned int ubrr = (F_CPU / (8UL * UART_BAUDERATE)) - 1;
+
+  UCSR0A = (1 << U2X0); // Double speed (20.3.2)
+  UBRR0H = (uint8_t)(ubrr >> 8);
+  UBRR0L = (uint8_t)ubrr;
+  UCSR0B = (1 << TXEN0);
+  UCSR0C = (1 << UCSZ01) | (1 << UCSZ00); // 8N1
+}
+
+
+void uart_tx(char c) {
+  while (!(UCSR0A & (1 << UDRE0))) {}
+  UDR0 = c;
+}
+
+
+void uart_printstr(const char *str) {
+  while (*str) {
+    uart_tx(*str++);
+  }
+}
+
+
+void uart_printnbr(uint32_t n) {
+  char buf[10];
+  uint8_t i = 0;
+
+  do {
+    buf[i++] = '0' + n % 10;
+    n /= 10;
+  } while (n);
+  while (i) {
+    uart_tx(buf[--i]);
+  }
+}
@@ -16,10 +16,53 @@
 
 # define MYUBRR F_CPU / 8 / UART_BAUDERATE - 1 // Formula for Asynchronous double speed mode (20.3.1)
 
+// Transmit ring buffer drained by the USART_UDRE interrupt, size must be a power of 2
+# ifndef UART_TX_SIZE
+#  define UART_TX_SIZE 64
+# endif
+# define UART_TX_MASK (UART_TX_SIZE - 1)
+// Indices are masked uint8_t: power of 2, 256 at most
+# if (UART_TX_SIZE & UART_TX_MASK) || UART_TX_SIZE > 256
+#  error "UART_TX_SIZE must be a power of 2 <= 256"
+# endif
+
+// What uart_tx does when the ring is full (build with -DUART_TX_POLICY=...)
+# define UART_TX_BLOCK 0      // wait for room, never lose a byte
+# define UART_TX_DROP 1       // discard the new byte
+# define UART_TX_OVERWRITE 2  // discard the oldest queued byte
+# ifndef UART_TX_POLICY
+#  define UART_TX_POLICY UART_TX_BLOCK
+# endif
+
+// Receive ring buffer filled by the USART_RX interrupt, size must be a power of 2
+# ifndef UART_RX_SIZE
+#  define UART_RX_SIZE 64
+# endif
+# define UART_RX_MASK (UART_RX_SIZE - 1)
+// Indices are masked uint8_t: power of 2, 256 at most
+# if (UART_RX_SIZE & UART_RX_MASK) || UART_RX_SIZE > 256
+#  error "UART_RX_SIZE must be a power of 2 <= 256"
+# endif
+
+// Build with -DUART_RX_LINES=1 to assemble lines (backspace, enter) in the
+// RX interrupt and fetch complete lines with uart_getline()
+# ifndef UART_RX_LINES
+#  define UART_RX_LINES 0
+# endif
+# define UART_LINE_SLOTS 2
+# define UART_LINE_SIZE 64
+
 void  uart_init(unsigned int ubrr);
 void  uart_printstr(const char *str);
 void  uart_tx(unsigned char c);
+uint8_t uart_write(const char *buf, uint8_t len);
+void  uart_flush(void);
+uint16_t uart_tx_overflows(void);
 char  uart_rx(void);
+uint8_t uart_rx_available(void);
+uint8_t uart_getline(char *buffer, uint8_t max_len);
+uint16_t uart_rx_overruns(void);
+uint16_t uart_rx_hw_overruns(void);
 void  uart_putnbr(uint16_t n);
 
 void	putnbr_hexa(uint32_t nb);
@@ -6,15 +6,6 @@
 #define BUFFER_SIZE 64
 
 char rcv_buffer[BUFFER_SIZE];
-int rainbow_flag = 0;
-
-
-// Handle uart receive intterupt
-void __vector_18(void) __attribute__ ((signal, used, externally_visible));
-void __vector_18(void) {
-    rainbow_flag = 0; // Set rainbow_flag to end the loop when a char is received
-    uint8_t c = UDR0; // Read the byte received to clean the register
-}
 
 
 uint32_t  handle_backspace(char *rcv_buffer, uint32_t count, char c) {
@@ -80,15 +71,13 @@ void color_mode(uint8_t del_num) {
 
 
 void rainbow_mode() {
-  rainbow_flag = 1;
   uint8_t pos = 0;
-  sei();
-  while (rainbow_flag) {
+  // Any received char ends the loop, it stays queued as the start of the next command
+  while (!uart_rx_available()) {
     wheel(pos);
     pos++;
     _delay_ms(20);
   }
-  cli();
   color_mode(0);
 }
 
@@ -118,6 +107,14 @@ int parse_input() {
 
 
 // Fill the rcv_buffer with user input
+#if UART_RX_LINES
+// Line already assembled by the RX interrupt, echo it once complete
+void rcv_loop() {
+  while (!uart_getline(rcv_buffer, BUFFER_SIZE)) {}
+  uart_printstr(rcv_buffer);
+  uart_printstr("\r\n");
+}
+#else
 void rcv_loop() {
   char c;
   rcv_buffer[BUFFER_SIZE - 1] = '\0';
@@ -137,12 +134,13 @@ void rcv_loop() {
     }
   }
 }
+#endif
 
 
 int main() {
   spi_master_init();
   uart_init(MYUBRR);
-  SET_BIT(UCSR0B, RXCIE0);
+  sei(); // Needed by the transmit and receive rings (USART_UDRE / USART_RX interrupts)
   set_leds(0x00, 0x00, 0x00);
   while (1) {
     rcv_loop();
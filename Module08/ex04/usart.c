@@ -1,20 +1,257 @@
 #include "exo.h"
 #include <avr/io.h>
+#include <avr/interrupt.h>
 
+// Transmit ring buffer: main code writes at tx_head, the UDRE interrupt
+// reads at tx_tail. Empty when head == tail, full when head + 1 == tail.
+static volatile char tx_buf[UART_TX_SIZE];
+static volatile uint8_t tx_head = 0;
+static volatile uint8_t tx_tail = 0;
+static volatile uint16_t tx_overflows = 0;
+static volatile uint8_t tx_started = 0;
 
+// Receive side: the RX interrupt writes, main code reads.
+// rx_overruns counts bytes (or lines) lost because the software buffer was full,
+// rx_hw_overruns counts DOR0 events (byte overwritten in UDR0 before being read).
+#if UART_RX_LINES
+static volatile char line_buf[UART_LINE_SLOTS][UART_LINE_SIZE];
+static volatile uint8_t line_len = 0;
+static volatile uint8_t line_fill = 0;
+static volatile uint8_t line_read = 0;
+static volatile uint8_t line_count = 0;
+static volatile uint8_t line_drop = 0;  // line lost, ignored until its end
+#else
+static volatile char rx_buf[UART_RX_SIZE];
+static volatile uint8_t rx_head = 0;
+static volatile uint8_t rx_tail = 0;
+#endif
+static volatile uint16_t rx_overruns = 0;
+static volatile uint16_t rx_hw_overruns = 0;
+
+
+#if UART_RX_LINES
+// Line assembly, only called from the RX interrupt
+// With both slots full, line_fill is back on line_read, which main has not
+// read yet: the incoming line is dropped whole (one rx_overruns) instead of
+// overwriting the oldest one.
+static void uart_line_feed(char c) {
+  volatile char *line = line_buf[line_fill];
+
+  if (c == '\r' || c == '\n') {
+    if (line_drop) {
+      line_drop = 0;
+      return;
+    }
+    if (line_len == 0 && c == '\n') {
+      return; // second half of a "\r\n" pair
+    }
+    if (line_count == UART_LINE_SLOTS) {
+      rx_overruns++;
+      return;
+    }
+    line[line_len] = '\0';
+    line_fill = (line_fill + 1) % UART_LINE_SLOTS;
+    line_count++;
+    line_len = 0;
+    return;
+  }
+  if (line_drop) {
+    return;
+  }
+  if (c == 0x7F || c == 0x08) {
+    if (line_len > 0) {
+      line_len--;
+    }
+  } else if (line_count == UART_LINE_SLOTS) {
+    // Start of a line with no free slot (line_len is 0: line_count only grows at end of line)
+    rx_overruns++;
+    line_drop = 1;
+  } else if (line_len < UART_LINE_SIZE - 1) {
+    line[line_len++] = c;
+  }
+}
+#endif
+
+
+// Handle uart receive interrupt (vector 18, USART_RX)
+// Store the byte right away so nothing is lost while main pushes SPI frames
+void __vector_18(void) __attribute__ ((signal, used, externally_visible));
+void __vector_18(void) {
+  // Error flags belong to the byte in the receive buffer, read them before UDR0 (20.7.4)
+  uint8_t status = UCSR0A;
+  char c = UDR0;
+
+  if (status & (1 << DOR0)) {
+    rx_hw_overruns++;
+  }
+#if UART_RX_LINES
+  uart_line_feed(c);
+#else
+  uint8_t next = (rx_head + 1) & UART_RX_MASK;
+  if (next == rx_tail) {
+    rx_overruns++;
+    return;
+  }
+  rx_buf[rx_head] = c;
+  rx_head = next;
+#endif
+}
+
+
+
+#if !UART_RX_LINES
 char uart_rx(void) {
-  // Wait for data to be received (20.7.1)
-  while (!(UCSR0A & (1 << RXC0))) {}
-  // Get and return received data from buffer (20.7.1)
-  return UDR0;
+  // Wait for the RX interrupt to queue a byte
+  while (rx_head == rx_tail) {}
+  char c = rx_buf[rx_tail];
+  rx_tail = (rx_tail + 1) & UART_RX_MASK;
+  return c;
+}
+#endif
+
+
+// Bytes waiting, or in line mode complete lines plus the one being typed
+uint8_t uart_rx_available(void) {
+#if UART_RX_LINES
+  return line_count + (line_len != 0);
+#else
+  return (rx_head - rx_tail) & UART_RX_MASK;
+#endif
+}
+
+
+// Copy the next complete line into buffer, return 1 if there was one (non blocking)
+uint8_t uart_getline(char *buffer, uint8_t max_len) {
+#if UART_RX_LINES
+  if (line_count == 0) {
+    return 0;
+  }
+  // The ISR leaves slot line_read alone while line_count > 0
+  uint8_t i = 0;
+  while (i < max_len - 1 && line_buf[line_read][i]) {
+    buffer[i] = line_buf[line_read][i];
+    i++;
+  }
+  buffer[i] = '\0';
+  line_read = (line_read + 1) % UART_LINE_SLOTS;
+  uint8_t sreg = SREG;
+  cli();
+  line_count--;
+  SREG = sreg;
+  return 1;
+#else
+  (void)buffer;
+  (void)max_len;
+  return 0;
+#endif
+}
+
+
+uint16_t uart_rx_overruns(void) {
+  uint8_t sreg = SREG;
+  cli();
+  uint16_t n = rx_overruns;
+  SREG = sreg;
+  return n;
+}
+
+
+uint16_t uart_rx_hw_overruns(void) {
+  uint8_t sreg = SREG;
+  cli();
+  uint16_t n = rx_hw_overruns;
+  SREG = sreg;
+  return n;
+}
+
+
+// Send the oldest queued byte, UDR0 must be empty
+static void uart_tx_next(void) {
+  // Clear TXC0 by writing a one (20.11.2), FE0/DOR0/UPE0 must be written to zero
+  UCSR0A = (1 << U2X0) | (1 << TXC0);
+  UDR0 = tx_buf[tx_tail];
+  tx_tail = (tx_tail + 1) & UART_TX_MASK;
+  tx_started = 1;
+}
+
+
+// Handle uart data register empty interrupt (vector 19, USART_UDRE)
+// Disable it once the ring is empty, otherwise it fires continuously (20.11.3)
+void __vector_19(void) __attribute__ ((signal, used, externally_visible));
+void __vector_19(void) {
+  if (tx_head == tx_tail) {
+    CLEAR_BIT(UCSR0B, UDRIE0);
+  } else {
+    uart_tx_next();
+  }
+}
+
+
+// Queue one byte, return 0 if it was dropped
+static uint8_t uart_tx_push(unsigned char c) {
+  uint8_t next = (tx_head + 1) & UART_TX_MASK;
+
+  while (next == tx_tail) {
+#if UART_TX_POLICY == UART_TX_DROP
+    tx_overflows++;
+    return 0;
+#elif UART_TX_POLICY == UART_TX_OVERWRITE
+    // tx_tail belongs to the ISR, move it with interrupts off
+    uint8_t sreg = SREG;
+    cli();
+    if (next == tx_tail) {
+      tx_tail = (tx_tail + 1) & UART_TX_MASK;
+      tx_overflows++;
+    }
+    SREG = sreg;
+#else
+    // With interrupts off the ISR never drains the ring, so poll it out here
+    if (!(SREG & (1 << SREG_I)) && (UCSR0A & (1 << UDRE0))) {
+      uart_tx_next();
+    }
+#endif
+  }
+  tx_buf[tx_head] = c;
+  tx_head = next;
+  // Interrupt fires as soon as UDR0 is empty (20.6.3)
+  SET_BIT(UCSR0B, UDRIE0);
+  return 1;
 }
 
 
 void  uart_tx(unsigned char c) {
-  // Wait for empty transmit buffer (20.6.1)
-  while (!(UCSR0A & (1 << UDRE0))) {}
-  // Put data into buffer, send the data (20.6.1)
-  UDR0 = c;
+  uart_tx_push(c);
+}
+
+
+uint8_t uart_write(const char *buf, uint8_t len) {
+  uint8_t sent = 0;
+  while (sent < len && uart_tx_push(buf[sent])) {
+    sent++;
+  }
+  return sent;
+}
+
+
+// Wait until the ring is empty and the last byte left the shift register
+void uart_flush(void) {
+  while (tx_head != tx_tail) {
+    if (!(SREG & (1 << SREG_I)) && (UCSR0A & (1 << UDRE0))) {
+      uart_tx_next();
+    }
+  }
+  if (tx_started) {
+    while (!(UCSR0A & (1 << TXC0))) {}
+  }
+}
+
+
+uint16_t uart_tx_overflows(void) {
+  uint8_t sreg = SREG;
+  cli();
+  uint16_t n = tx_overflows;
+  SREG = sreg;
+  return n;
 }
 
 
@@ -47,8 +284,8 @@ void uart_init(unsigned int ubrr) {
   UBRR0H = (unsigned char) (ubrr >> 8);
   UBRR0L = (unsigned char) ubrr;
 
-  // Enable trasmitter and receiver (20.5)
-  UCSR0B = (1 << TXEN0) | (1 << RXEN0);
+  // Enable trasmitter and receiver (20.5), and the receive complete interrupt (20.11.3)
+  UCSR0B = (1 << TXEN0) | (1 << RXEN0) | (1 << RXCIE0);
 
   // Enable 8N1 (20.5)
   CLEAR_BIT(UCSR0C, UPM00);